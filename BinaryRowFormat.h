@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Layout of the binary mission table output (--format bin)
+// A consumer can memory map the output and walk records in place, without parsing.
+//
+// The file starts with BinaryRowFileHeader, followed by records until end of file.
+// Each record is a BinaryRowHeader followed by the path, filename, mapName, techtreeName and levelDesc strings in order.
+// Each string is null terminated, and its size excludes the terminator.
+// Records are padded to a multiple of 4 bytes, so every BinaryRowHeader is 4 byte aligned.
+// All values are little endian whatever the byte order of the host writing them.
+
+
+#pragma pack(push, 1) // Make sure structure is byte aligned
+
+struct BinaryRowFileHeader
+{
+	std::array<char, 8> signature;
+};
+
+static_assert(8 == sizeof(BinaryRowFileHeader), "BinaryRowFileHeader is an unexpected size");
+
+constexpr std::array<char, 8> binaryRowSignature{ 'M', 'S', 'R', 'O', 'W', 'S', '0', '2' };
+
+
+enum BinaryRowFlags : std::uint32_t
+{
+	BinaryRowHasAIModDesc = 1 << 0,
+	BinaryRowHasMapName = 1 << 1,
+	BinaryRowHasTechtreeName = 1 << 2,
+	BinaryRowHasLevelDesc = 1 << 3,
+};
+
+struct BinaryRowHeader
+{
+	// Total size of the record including this header and padding. Offset to the next record.
+	std::uint32_t recordSize;
+	std::uint32_t flags;
+	std::uint32_t timeDateStamp;
+
+	// AIModDesc fields, zero when BinaryRowHasAIModDesc is not set
+	std::int32_t missionType;
+	std::int32_t numPlayers;
+	std::int32_t maxTechLevel;
+	std::int32_t boolUnitMission;
+	std::int32_t checksum;
+
+	std::uint32_t pathSize;
+	std::uint32_t filenameSize;
+	std::uint32_t mapNameSize;
+	std::uint32_t techtreeNameSize;
+	std::uint32_t levelDescSize;
+};
+
+static_assert(52 == sizeof(BinaryRowHeader), "BinaryRowHeader is an unexpected size");
+
+#pragma pack(pop)
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+
+
+// Values in native byte order and length prefixed strings, as stored in the scan cache and sort run files.
+// Enable exceptions on streams, so short reads and failed writes throw.
+
+constexpr std::uint32_t maxStoredStringSize = 1 << 20;
+
+template <typename DataType>
+void WriteValue(std::ostream& stream, const DataType& value)
+{
+	static_assert(std::is_trivially_copyable_v<DataType>, "Type must be trivially copyable");
+
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void WriteString(std::ostream& stream, const std::string& value)
+{
+	WriteValue(stream, static_cast<std::uint32_t>(value.size()));
+	stream.write(value.data(), value.size());
+}
+
+template <typename DataType>
+DataType ReadValue(std::istream& stream)
+{
+	static_assert(std::is_trivially_copyable_v<DataType>, "Type must be trivially copyable");
+
+	DataType value;
+	stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+inline std::string ReadString(std::istream& stream)
+{
+	const auto size = ReadValue<std::uint32_t>(stream);
+
+	// Guard against huge allocations from a corrupt file
+	if (size > maxStoredStringSize) {
+		throw std::runtime_error("Stored string length exceeds limit : " + std::to_string(size));
+	}
+
+	std::string value(size, '\0');
+	stream.read(value.data(), value.size());
+	return value;
+}
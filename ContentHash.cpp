@@ -0,0 +1,74 @@
+#include "ContentHash.h"
+#include <cstring>
+
+
+std::uint64_t RotateLeft(std::uint64_t value, int bitCount);
+std::uint64_t MixWord(std::uint64_t hash, std::uint64_t word);
+std::uint64_t MixByte(std::uint64_t hash, unsigned char byte);
+std::uint64_t Avalanche(std::uint64_t hash);
+
+// Primes and mixing steps of xxHash64, consuming a single 8 byte word per round
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+constexpr std::uint64_t prime3 = 0x165667B19E3779F9;
+constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63;
+constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5;
+
+// The check hash is seeded with fractional digits of pi, so it follows a different path through the same rounds
+constexpr std::uint64_t hashSeed = 0;
+constexpr std::uint64_t checkHashSeed = 0x243F6A8885A308D3;
+
+
+// Both hashes consume each word as it is loaded, so the data is only read once
+ContentDigest DigestContent(std::string_view data)
+{
+	std::uint64_t hash = hashSeed + prime5 + data.size();
+	std::uint64_t checkHash = checkHashSeed + prime5 + data.size();
+
+	std::size_t offset = 0;
+	for (; data.size() - offset >= sizeof(std::uint64_t); offset += sizeof(std::uint64_t)) {
+		std::uint64_t word;
+		std::memcpy(&word, data.data() + offset, sizeof(word));
+		hash = MixWord(hash, word);
+		checkHash = MixWord(checkHash, word);
+	}
+
+	for (; offset < data.size(); ++offset) {
+		hash = MixByte(hash, static_cast<unsigned char>(data[offset]));
+		checkHash = MixByte(checkHash, static_cast<unsigned char>(data[offset]));
+	}
+
+	return ContentDigest{ data.size(), Avalanche(hash), Avalanche(checkHash) };
+}
+
+
+std::uint64_t RotateLeft(std::uint64_t value, int bitCount)
+{
+	return (value << bitCount) | (value >> (64 - bitCount));
+}
+
+std::uint64_t MixWord(std::uint64_t hash, std::uint64_t word)
+{
+	word *= prime2;
+	word = RotateLeft(word, 31);
+	word *= prime1;
+	hash ^= word;
+	return RotateLeft(hash, 27) * prime1 + prime4;
+}
+
+std::uint64_t MixByte(std::uint64_t hash, unsigned char byte)
+{
+	hash ^= byte * prime5;
+	return RotateLeft(hash, 11) * prime1;
+}
+
+// Final avalanche, so every input bit affects every output bit
+std::uint64_t Avalanche(std::uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+
+// Identity of a block of memory, for recognizing files with identical content.
+// Size and two independently seeded 64 bit hashes must all match, so a collision crafted against one hash is not enough.
+// Hashes are fast and non-cryptographic.
+struct ContentDigest
+{
+	std::uint64_t size;
+	std::uint64_t hash;
+	std::uint64_t checkHash;
+
+	bool operator==(const ContentDigest& other) const
+	{
+		return size == other.size && hash == other.hash && checkHash == other.checkHash;
+	}
+};
+
+// For unordered containers keyed by digest
+struct ContentDigestHasher
+{
+	std::size_t operator()(const ContentDigest& contentDigest) const
+	{
+		return static_cast<std::size_t>(contentDigest.hash);
+	}
+};
+
+ContentDigest DigestContent(std::string_view data);
@@ -2,116 +2,408 @@
 #include <array>
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
 
 // http://www.delphibasics.info/home/delphibasicsarticles/anin-depthlookintothewin32portableexecutablefileformat-part1
 // http://www.delphibasics.info/home/delphibasicsarticles/anin-depthlookintothewin32portableexecutablefileformat-part2
 // https://docs.microsoft.com/en-us/windows/win32/debug/pe-format
 
 
-DllExportReader32::DllExportReader32(const std::string& filename) :
-	stream(filename)
-{	
+DllExportReader32::DllExportReader32(const std::string& filename)
+{
+	Open(filename);
+}
+
+DllExportReader32::DllExportReader32(Stream::SeekableReader& stream)
+{
+	Open(stream);
+}
+
+void DllExportReader32::Open(const std::string& filename)
+{
+	Close();
+
+	mappedFile = MappedFile(filename);
+	Reset(mappedFile.View());
+	LoadHeaders();
+}
+
+void DllExportReader32::Open(Stream::SeekableReader& stream)
+{
+	Close();
+
+	imageBuffer.resize(static_cast<std::size_t>(stream.Length() - stream.Position()));
+	stream.Read(imageBuffer.data(), imageBuffer.size());
+
+	Reset(std::string_view(imageBuffer.data(), imageBuffer.size()));
+	LoadHeaders();
+}
+
+void DllExportReader32::Open(std::string_view fileImage)
+{
+	Close();
+
+	Reset(fileImage);
+	LoadHeaders();
+}
+
+void DllExportReader32::Close()
+{
+	mappedFile = MappedFile();
+	imageBuffer.clear();
+	Reset(std::string_view());
+}
+
+DllExportReader32::HeaderProbe DllExportReader32::ProbeHeaders(std::string_view headerPrefix, bool isWholeFile)
+{
+	Close();
+	Reset(headerPrefix);
+	isHeaderPrefix = !isWholeFile;
+
+	HeaderProbe headerProbe;
+	try {
+		headerProbe.hasExportTable = ReadHeaders().has_value();
+	}
+	catch (const HeaderPrefixExhausted&) {
+		headerProbe.hasExportTable = true;
+	}
+	catch (...) {
+		Reset(std::string_view());
+		throw;
+	}
+
+	headerProbe.timeDateStamp = timeDateStamp;
+	headerProbe.readCounters = readCounters;
+	if (isImageFormatRead) {
+		headerProbe.imageFormat = imageFormat;
+	}
+
+	// The prefix belongs to the caller, so is not kept
+	Reset(std::string_view());
+	return headerProbe;
+}
+
+// Clears details of the previous file, keeping the capacity of its tables
+void DllExportReader32::Reset(std::string_view newImage)
+{
+	image = newImage;
+	timeDateStamp = 0;
+	imageFormat = ImageFormat::Other;
+	isImageFormatRead = false;
+	imageBase = 0;
+	isHeaderPrefix = false;
+
+	sectionTables.clear();
+	exportSectionTable = SectionTable{};
+	exportNamePointerTableOffset = 0;
+	exportAddressTableOffset = 0;
+	exportOrdinalTableOffset = 0;
+	exportNameCount = 0;
+	exportAddressCount = 0;
+	exportOrdinalBase = 0;
+	exportDirectory = ImageDataDirectory{};
+	exportNameTable.clear();
+	exportNameIndex.clear();
+
+	readCounters = ImageReadCounters();
+	readCounters.imageSize = image.size();
+	nextReadOffset = 0;
+}
+
+void DllExportReader32::LoadHeaders()
+{
+	const auto exportTableEntry = ReadHeaders();
+	if (exportTableEntry) {
+		LoadExportTable(*exportTableEntry);
+	}
+}
+
+// Validates headers and reads section tables. Returns the export table entry if the DLL has one.
+// Images with an unrecognized optional header are treated as having no export table.
+std::optional<ImageDataDirectory> DllExportReader32::ReadHeaders()
+{
 	if (!IsPortableExecutableFile()) {
 		throw std::runtime_error("Not a Portable Exectuable file");
 	}
 
-	CoffHeader coffHeader;
-	stream.Read(coffHeader);
+	// Headers follow the PE signature sequentially
+	const std::size_t coffHeaderOffset = ReadAt<std::uint32_t>(0x3c) + sizeof(std::array<char, 4>);
+	const auto coffHeader = ReadAt<CoffHeader>(coffHeaderOffset);
 
 	if (!IsDll(coffHeader)) { 
 		throw std::runtime_error("Not a DLL file");
 	}
 
-	Image32Bit image32Bit;
-	stream.Read(image32Bit);
+	timeDateStamp = coffHeader.timeDateStamp;
+
+	// Layout is chosen once, so lookups after opening do not depend on the format
+	const auto optionalHeaderOffset = coffHeaderOffset + sizeof(CoffHeader);
+	const auto magic = ReadAt<std::uint16_t>(optionalHeaderOffset);
+	isImageFormatRead = true;
+
+	switch (magic)
+	{
+	case image32BitMagic:
+		imageFormat = ImageFormat::Pe32;
+		return ReadOptionalHeader<Image32Bit>(coffHeader, optionalHeaderOffset);
+	case image64BitMagic:
+		imageFormat = ImageFormat::Pe32Plus;
+		return ReadOptionalHeader<Image64Bit>(coffHeader, optionalHeaderOffset);
+	default:
+		imageFormat = ImageFormat::Other;
+		return std::nullopt;
+	}
+}
+
+template <typename ImageHeader>
+std::optional<ImageDataDirectory> DllExportReader32::ReadOptionalHeader(const CoffHeader& coffHeader, std::size_t optionalHeaderOffset)
+{
+	const auto imageHeader = ReadAt<ImageHeader>(optionalHeaderOffset);
+	imageBase = imageHeader.imageBase;
 
-	if (image32Bit.magic != 0x10b) {
-		throw std::runtime_error("Unsupported DLL or EXE : Must be 32-bit architecture");
+	// Data directories end with the optional header, so a larger numberOfRvaAndSizes does not move the section tables
+	if (coffHeader.sizeOfOptionalHeader < sizeof(ImageHeader)) {
+		throw std::runtime_error("Optional header is too small : " + std::to_string(coffHeader.sizeOfOptionalHeader));
 	}
+	const auto dataDirectoryCount = std::min<std::size_t>(imageHeader.numberOfRvaAndSizes,
+		(coffHeader.sizeOfOptionalHeader - sizeof(ImageHeader)) / sizeof(ImageDataDirectory));
 
-	std::vector<ImageDataDirectory> imageDataDirectories(image32Bit.numberOfRvaAndSizes);
-	stream.Read(imageDataDirectories);
+	// Section count is checked against the file size before the tables are allocated
+	const auto sectionTablesOffset = optionalHeaderOffset + coffHeader.sizeOfOptionalHeader;
+	CheckFileRange(sectionTablesOffset, static_cast<std::uint64_t>(coffHeader.numberOfSections) * sizeof(SectionTable));
 
 	sectionTables.resize(coffHeader.numberOfSections);
-	stream.Read(sectionTables);
+	for (std::size_t i = 0; i < sectionTables.size(); ++i) {
+		sectionTables[i] = ReadAt<SectionTable>(sectionTablesOffset + i * sizeof(SectionTable));
+	}
+
+	// Data directories do not include an export table entry
+	if (dataDirectoryCount == 0) {
+		return std::nullopt;
+	}
 
-	const ImageDataDirectory& exportTableEntry = imageDataDirectories[0];
+	const auto exportTableEntry = ReadAt<ImageDataDirectory>(optionalHeaderOffset + sizeof(ImageHeader));
 
 	// No export table is available to pull from
 	if (exportTableEntry.virtualAddress == 0) {
-		return;
+		return std::nullopt;
 	}
 
-	SectionTable sectionTable = FindSectionTableContainingRva(exportTableEntry.virtualAddress);
+	exportSectionTable = FindSectionTableContainingRva(exportTableEntry.virtualAddress);
+
+	return exportTableEntry;
+}
 
-	stream.Seek(RvaToFileOffset(exportTableEntry.virtualAddress, sectionTable));
-	ExportDirectoryTable exportDirectoryTable;
-	stream.Read(exportDirectoryTable);
+void DllExportReader32::LoadExportTable(const ImageDataDirectory& exportTableEntry)
+{
+	const auto exportDirectoryTable = ReadAt<ExportDirectoryTable>(
+		RvaToFileOffset(exportTableEntry.virtualAddress, exportSectionTable, sizeof(ExportDirectoryTable)));
+
+	// Tables are only located here. Entries are read by lookups.
+	// Whole tables must lie within the export section, so lookups never index past the file whatever the counts claim.
+	exportNameCount = exportDirectoryTable.numberOfNamePointers;
+	if (exportNameCount != 0) {
+		exportNamePointerTableOffset = RvaToFileOffset(exportDirectoryTable.namePointerRva, exportSectionTable,
+			static_cast<std::uint64_t>(exportNameCount) * sizeof(std::uint32_t));
+		exportOrdinalTableOffset = RvaToFileOffset(exportDirectoryTable.ordinalTableRva, exportSectionTable,
+			static_cast<std::uint64_t>(exportNameCount) * sizeof(std::uint16_t));
+	}
 
-	LoadNameTable(exportDirectoryTable.namePointerRva, sectionTable, exportDirectoryTable.numberOfNamePointers);
-	
-	std::vector<std::uint16_t> exportOrdinalTable(exportNameTable.size());
-	stream.Seek(RvaToFileOffset(exportDirectoryTable.ordinalTableRva, sectionTable));
-	stream.Read(exportOrdinalTable);
+	exportAddressCount = exportDirectoryTable.addressTableEntries;
+	if (exportAddressCount != 0) {
+		exportAddressTableOffset = RvaToFileOffset(exportDirectoryTable.exportAddressTableRva, exportSectionTable,
+			static_cast<std::uint64_t>(exportAddressCount) * sizeof(std::uint32_t));
+	}
 
-	exportAddressTable.resize(exportNameTable.size());
-	stream.Seek(RvaToFileOffset(exportDirectoryTable.exportAddressTableRva, sectionTable));
-	stream.Read(exportAddressTable);
+	exportOrdinalBase = exportDirectoryTable.ordinalBase;
+	exportDirectory = exportTableEntry;
 }
 
 SectionTable DllExportReader32::FindSectionTableContainingRva(std::uint32_t rva)
+{
+	const auto sectionTable = FindSectionTable(rva);
+	if (sectionTable == nullptr) {
+		throw std::runtime_error("No Section Table contains RVA : " + std::to_string(rva));
+	}
+
+	return *sectionTable;
+}
+
+const SectionTable* DllExportReader32::FindSectionTable(std::uint32_t rva) const
 {
 	for (const SectionTable& sectionTable : sectionTables)
 	{
-		if (rva >= sectionTable.virtualAddress &&
-			rva <= sectionTable.virtualAddress + sectionTable.virtualSize)
+		if (SectionContainsRva(sectionTable, rva))
 		{
-			return sectionTable;
+			return &sectionTable;
 		}
 	}
 
-	throw std::runtime_error("No Section Table contains RVA : " + std::to_string(rva));
+	return nullptr;
 }
 
-void DllExportReader32::LoadNameTable(std::uint32_t rva, const SectionTable& sectionTable, std::size_t count)
+// Some linkers leave virtualSize zero, so the raw data size is used instead.
+// Compares offsets from the section start, so sections ending at the top of the address space do not overflow.
+bool DllExportReader32::SectionContainsRva(const SectionTable& sectionTable, std::uint32_t rva)
 {
-	stream.Seek(RvaToFileOffset(rva, sectionTable));
-	std::vector<uint32_t> exportNamePointerTable(count);
-	stream.Read(exportNamePointerTable);
+	const auto sectionSize = sectionTable.virtualSize != 0 ? sectionTable.virtualSize : sectionTable.sizeOfRawData;
 
-	for (std::size_t i = 0; i < exportNamePointerTable.size(); ++i)
-	{
-		stream.Seek(RvaToFileOffset(exportNamePointerTable[i], sectionTable));
-		exportNameTable.push_back(stream.ReadNullTerminatedString());
+	return rva >= sectionTable.virtualAddress &&
+		rva - sectionTable.virtualAddress < sectionSize;
+}
+
+std::string_view DllExportReader32::ReadExportName(std::size_t index) const
+{
+	const auto namePointer = ReadAt<std::uint32_t>(exportNamePointerTableOffset + index * sizeof(std::uint32_t));
+	return ReadNullTerminatedStringAt(RvaToFileOffset(namePointer, exportSectionTable, 1));
+}
+
+// Reads every name, for tables from non-conforming linkers that are not sorted
+void DllExportReader32::BuildExportNameIndex()
+{
+	exportNameTable.reserve(exportNameCount);
+	for (std::size_t i = 0; i < exportNameCount; ++i) {
+		exportNameTable.push_back(ReadExportName(i));
+	}
+
+	exportNameIndex.resize(exportNameTable.size());
+	for (std::size_t i = 0; i < exportNameIndex.size(); ++i) {
+		exportNameIndex[i] = i;
+	}
+
+	std::sort(exportNameIndex.begin(), exportNameIndex.end(), [this](std::size_t a, std::size_t b) {
+		return exportNameTable[a] < exportNameTable[b];
+	});
+}
+
+// The PE format requires the name pointer table to be lexically sorted so the loader can binary search it.
+// Names are binary searched in place, reading only the names probed.
+// A probe that is out of order with earlier probes shows the table is not sorted, and switches to a sorted index.
+// A miss is trusted without reading the other names, as the Windows loader would not find the export either.
+std::optional<std::size_t> DllExportReader32::FindExportNamePosition(std::string_view exportName)
+{
+	if (!exportNameIndex.empty()) {
+		return FindExportNamePositionInIndex(exportName);
+	}
+
+	std::size_t first = 0;
+	std::size_t last = exportNameCount;
+	std::optional<std::string_view> lowerName;
+	std::optional<std::string_view> upperName;
+
+	while (first < last) {
+		const auto middle = first + (last - first) / 2;
+		const auto name = ReadExportName(middle);
+
+		if ((lowerName && name < *lowerName) || (upperName && name > *upperName)) {
+			BuildExportNameIndex();
+			return FindExportNamePositionInIndex(exportName);
+		}
+
+		if (name < exportName) {
+			first = middle + 1;
+			lowerName = name;
+		}
+		else if (name > exportName) {
+			last = middle;
+			upperName = name;
+		}
+		else {
+			return middle;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<std::size_t> DllExportReader32::FindExportNamePositionInIndex(std::string_view exportName) const
+{
+	const auto match = std::lower_bound(exportNameIndex.begin(), exportNameIndex.end(), exportName,
+		[this](std::size_t index, std::string_view name) {
+			return exportNameTable[index] < name;
+		});
+	if (match != exportNameIndex.end() && exportNameTable[*match] == exportName) {
+		return *match;
+	}
+	return std::nullopt;
+}
+
+std::string_view DllExportReader32::ReadNullTerminatedStringAt(std::size_t offset) const
+{
+	CheckFileRange(offset, 1);
+
+	const auto text = FindNullTerminatedStringAt(offset);
+	if (!text) {
+		throw std::runtime_error("String is not null terminated at offset : " + std::to_string(offset));
+	}
+
+	return *text;
+}
+
+// Searches at most maxStringSize bytes for the terminator
+std::optional<std::string_view> DllExportReader32::FindNullTerminatedStringAt(std::size_t offset) const
+{
+	if (offset >= image.size()) {
+		return std::nullopt;
+	}
+
+	const auto searchSize = std::min(image.size() - offset, maxStringSize);
+	const auto* terminator = static_cast<const char*>(std::memchr(image.data() + offset, '\0', searchSize));
+	if (terminator == nullptr) {
+		return std::nullopt;
+	}
+
+	const std::size_t stringSize = terminator - (image.data() + offset);
+	CountRead(offset, stringSize + 1);
+
+	return image.substr(offset, stringSize);
+}
+
+void DllExportReader32::CheckFileRange(std::uint64_t offset, std::uint64_t size) const
+{
+	if (offset > image.size() || image.size() - offset < size) {
+		if (isHeaderPrefix) {
+			throw HeaderPrefixExhausted();
+		}
+		throw std::runtime_error("Attempted to read past end of file at offset : " + std::to_string(offset));
 	}
 }
 
 // File Offset = RVA - Virtual Offset + Raw Offset.
-std::uint32_t DllExportReader32::RvaToFileOffset(std::uint32_t rva, const SectionTable& sectionTable)
+// Throws unless size bytes from the RVA lie within the section's raw data, and within the file.
+// Bytes past the raw data are uninitialized when loaded, and have no contents in the file.
+std::size_t DllExportReader32::RvaToFileOffset(std::uint32_t rva, const SectionTable& sectionTable, std::uint64_t size) const
 {
-	return rva - sectionTable.virtualAddress + sectionTable.pointerToRawData;
+	const std::uint64_t sectionOffset = static_cast<std::uint64_t>(rva) - sectionTable.virtualAddress;
+	if (rva < sectionTable.virtualAddress || sectionOffset > sectionTable.sizeOfRawData || sectionTable.sizeOfRawData - sectionOffset < size) {
+		throw std::runtime_error("RVA is outside of section data : " + std::to_string(rva));
+	}
+
+	const auto offset = sectionTable.pointerToRawData + sectionOffset;
+	CheckFileRange(offset, size);
+
+	return static_cast<std::size_t>(offset);
 }
 
 bool DllExportReader32::IsPortableExecutableFile()
 {
 	// Check if file is big enough to contain PE signature offset
-	if (stream.Length() < 0x3c + sizeof(std::uint32_t)) {
+	if (image.size() < 0x3c + sizeof(std::uint32_t)) {
 		return false;
 	}
 
-	stream.Seek(0x3c); // Seek to signature pointer
-	std::uint32_t peSignatureOffset;
-	stream.Read(peSignatureOffset);
+	const auto peSignatureOffset = ReadAt<std::uint32_t>(0x3c); // Signature pointer
 
 	// Check if file is big enough to contain PE signature
-	if (stream.Length() < peSignatureOffset + sizeof(std::array<char, 4>)) {
+	if (image.size() < static_cast<std::uint64_t>(peSignatureOffset) + sizeof(std::array<char, 4>)) {
+		if (isHeaderPrefix) {
+			throw HeaderPrefixExhausted();
+		}
 		return false;
 	}
 
-	stream.Seek(peSignatureOffset);
 	constexpr std::array<char, 4> peSignature{ 'P', 'E', '\0', '\0' };
-	std::array<char, 4> signature;
-	stream.Read(signature);
+	const auto signature = ReadAt<std::array<char, 4>>(peSignatureOffset);
 
 	return signature == peSignature;
 }
@@ -121,31 +413,132 @@ bool DllExportReader32::IsDll(const CoffHeader& coffHeader)
 	return (coffHeader.characteristics & 0x2000) == 0x2000; // IMAGE_FILE_DLL
 }
 
-std::string DllExportReader32::ReadExportString(const std::string& exportName)
+std::string_view DllExportReader32::ReadExportString(std::string_view exportName)
 {
-	stream.Seek(GetExportedFileOffset(exportName));
-	return stream.ReadNullTerminatedString();
+	return ReadNullTerminatedStringAt(GetExportedFileOffset(exportName));
 }
 
-std::size_t DllExportReader32::GetExportOrdinal(const std::string& exportName)
+std::optional<std::string_view> DllExportReader32::ReadStringAtVirtualAddress(std::uint64_t virtualAddress)
 {
-	for (std::size_t i = 0; i < exportNameTable.size(); ++i) {
-		if (exportName == exportNameTable[i]) {
-			return i;
+	// RVAs are 32 bit in both formats, so addresses more than 4 GiB above the image base are outside the image
+	if (virtualAddress == 0 || virtualAddress < imageBase || virtualAddress - imageBase > std::numeric_limits<std::uint32_t>::max()) {
+		return std::nullopt;
+	}
+
+	const auto rva = static_cast<std::uint32_t>(virtualAddress - imageBase);
+	const auto sectionTable = FindSectionTable(rva);
+
+	// Uninitialized data past the end of the section's raw data has no bytes in the file
+	if (sectionTable == nullptr || rva - sectionTable->virtualAddress >= sectionTable->sizeOfRawData) {
+		return std::nullopt;
+	}
+
+	return FindNullTerminatedStringAt(static_cast<std::size_t>(sectionTable->pointerToRawData) + (rva - sectionTable->virtualAddress));
+}
+
+std::size_t DllExportReader32::GetExportNamePosition(std::string_view exportName)
+{
+	const auto ordinal = FindExportNamePosition(exportName);
+	if (ordinal) {
+		return *ordinal;
+	}
+
+	throw std::runtime_error("DLL does not contain export : " + std::string(exportName));
+}
+
+std::size_t DllExportReader32::GetExportedFileOffset(std::string_view exportName)
+{
+	const auto rva = ReadExportAddress(GetExportAddressIndex(GetExportNamePosition(exportName)));
+
+	return RvaToFileOffset(rva, FindSectionTableContainingRva(rva), 1);
+}
+
+// Exported variables are usually grouped in a few sections, so neighbouring exports reuse the previous section
+void DllExportReader32::GetExportedFileOffsets(const std::string_view* exportNames, std::size_t* fileOffsets, std::size_t count)
+{
+	std::optional<SectionTable> sectionTable;
+	for (std::size_t i = 0; i < count; ++i) {
+		const auto rva = ReadExportAddress(GetExportAddressIndex(GetExportNamePosition(exportNames[i])));
+		if (!sectionTable || !SectionContainsRva(*sectionTable, rva)) {
+			sectionTable = FindSectionTableContainingRva(rva);
 		}
+		fileOffsets[i] = RvaToFileOffset(rva, *sectionTable, 1);
 	}
+}
+
+// The ordinal table maps positions in the name table to unbiased indexes into the address table.
+// Names and addresses only line up by position when the linker assigned ordinals in name order.
+std::size_t DllExportReader32::GetExportAddressIndex(std::size_t namePosition) const
+{
+	return ReadAt<std::uint16_t>(exportOrdinalTableOffset + namePosition * sizeof(std::uint16_t));
+}
+
+std::uint32_t DllExportReader32::ReadExportAddress(std::size_t index) const
+{
+	if (index >= exportAddressCount) {
+		throw std::runtime_error("Export address table does not contain index : " + std::to_string(index));
+	}
+
+	return ReadAt<std::uint32_t>(exportAddressTableOffset + index * sizeof(std::uint32_t));
+}
 
-	throw std::runtime_error("DLL does not contain export : " + exportName);
+bool DllExportReader32::DoesExportExist(std::string_view exportName)
+{
+	return FindExportNamePosition(exportName).has_value();
 }
 
-std::uint32_t DllExportReader32::GetExportedFileOffset(const std::string& exportName)
+ContentDigest DllExportReader32::DigestImage() const
 {
-	const auto rva = exportAddressTable[GetExportOrdinal(exportName)];
+	CountRead(0, image.size());
+	return DigestContent(image);
+}
 
-	return RvaToFileOffset(rva, FindSectionTableContainingRva(rva));
+bool DllExportReader32::IsForwarderRva(std::uint32_t rva) const
+{
+	return rva >= exportDirectory.virtualAddress && rva - exportDirectory.virtualAddress < exportDirectory.size;
 }
 
-bool DllExportReader32::DoesExportExist(const std::string& exportName)
+void DllExportReader32::ForEachExport(const std::function<void(const ExportEntry& exportEntry)>& visitor)
 {
-	return std::find(exportNameTable.begin(), exportNameTable.end(), exportName) != exportNameTable.end();
+	namedExportAddresses.assign(exportAddressCount, false);
+
+	for (std::size_t namePosition = 0; namePosition < exportNameCount; ++namePosition) {
+		const auto addressIndex = GetExportAddressIndex(namePosition);
+		if (addressIndex < namedExportAddresses.size()) {
+			namedExportAddresses[addressIndex] = true;
+		}
+		visitor(ReadExportEntry(addressIndex, ReadExportName(namePosition)));
+	}
+
+	for (std::size_t addressIndex = 0; addressIndex < exportAddressCount; ++addressIndex) {
+		if (namedExportAddresses[addressIndex]) {
+			continue;
+		}
+
+		const auto exportEntry = ReadExportEntry(addressIndex, std::string_view());
+		if (exportEntry.rva != 0) {
+			visitor(exportEntry);
+		}
+	}
+}
+
+DllExportReader32::ExportEntry DllExportReader32::ReadExportEntry(std::size_t addressIndex, std::string_view name) const
+{
+	ExportEntry exportEntry;
+	exportEntry.ordinal = exportOrdinalBase + static_cast<std::uint32_t>(addressIndex);
+	exportEntry.name = name;
+	exportEntry.rva = ReadExportAddress(addressIndex);
+
+	const auto sectionTable = FindSectionTable(exportEntry.rva);
+	if (sectionTable != nullptr) {
+		// Names shorter than 8 characters are null padded, while 8 character names have no terminator
+		const auto nameEnd = std::find(std::begin(sectionTable->name), std::end(sectionTable->name), '\0');
+		exportEntry.sectionName = std::string_view(sectionTable->name, nameEnd - std::begin(sectionTable->name));
+	}
+
+	if (IsForwarderRva(exportEntry.rva)) {
+		exportEntry.forwarder = ReadNullTerminatedStringAt(RvaToFileOffset(exportEntry.rva, exportSectionTable, 1));
+	}
+
+	return exportEntry;
 }
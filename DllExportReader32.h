@@ -1,47 +1,286 @@
 #pragma once
 
 #include "PEDataStructures.h"
+#include "MappedFile.h"
+#include "ContentHash.h"
 #include "OP2Utility.h"
 #include <vector>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <cstddef>
+#include <cstring>
+#include <optional>
+#include <functional>
+#include <stdexcept>
 #include <type_traits>
 
 
-// Access exported variables from a 32 bit DLL without loading the DLL into memory.
+// Accesses made to the image while parsing, for measuring how much of each file is read
+struct ImageReadCounters
+{
+	std::uint64_t imageSize = 0;
+	std::uint64_t bytesRead = 0;
+	std::uint64_t readCount = 0;
+
+	// Reads that do not start where the previous read ended
+	std::uint64_t seekCount = 0;
+
+	ImageReadCounters& operator+=(const ImageReadCounters& other)
+	{
+		imageSize += other.imageSize;
+		bytesRead += other.bytesRead;
+		readCount += other.readCount;
+		seekCount += other.seekCount;
+		return *this;
+	}
+};
+
+// Access exported variables from a DLL without loading the DLL into memory.
+// Reads both PE32 (32 bit) and PE32+ (64 bit) images. Export tables have the same layout in both,
+// so only the optional header is read differently, chosen once per file by its magic number.
+// Images with any other optional header are opened without exports, rather than rejected with an exception.
+// The file is memory mapped, so headers and export names are read directly from the mapped image.
+// Opening only validates headers and locates the export table. Export names are read as lookups need them.
+// Files may be untrusted. Counts and RVAs read from the file are checked against the file size and section bounds
+// before use, so corrupt files are rejected without large allocations or long scans.
 class DllExportReader32
 {
 public:
+	// Constructs a reader with no file open. Call Open before reading exports.
+	DllExportReader32() = default;
+
 	explicit DllExportReader32(const std::string& filename);
 
-	std::string ReadExportString(const std::string& exportName);
+	// Reads the remainder of the stream into memory, such as a DLL packed inside an archive
+	explicit DllExportReader32(Stream::SeekableReader& stream);
+
+	// Replaces any open file. A reader reused across many files keeps its buffers, so opening a file does not allocate.
+	void Open(const std::string& filename);
+	void Open(Stream::SeekableReader& stream);
+
+	// Opens an image already in memory, such as a fuzzer input. The image must stay valid until the reader closes or opens another file.
+	void Open(std::string_view fileImage);
+
+	// Releases the file, keeping buffers for the next Open
+	void Close();
+
+	enum class ImageFormat
+	{
+		Pe32,
+		Pe32Plus,
+		// Optional header of another layout, such as a ROM image. No exports are read.
+		Other,
+	};
+
+	struct HeaderProbe
+	{
+		bool hasExportTable;
+		std::uint32_t timeDateStamp;
+		ImageReadCounters readCounters;
+
+		// Empty if the prefix ended before the optional header
+		std::optional<ImageFormat> imageFormat;
+	};
+
+	// Size of the file prefix to pass to ProbeHeaders. Covers the headers of typical DLLs.
+	static constexpr std::size_t headerProbeSize = 4096;
+
+	// Longest string searched for a null terminator, so a missing terminator does not scan the rest of a large file
+	static constexpr std::size_t maxStringSize = 64 * 1024;
+
+	// Validates headers from the start of a file, throwing the same errors as Open.
+	// Lets a caller skip DLLs without an export table before reading the whole file.
+	// Headers extending past a partial prefix are reported as having an export table, leaving the decision to a full reader.
+	// Closes any open file.
+	HeaderProbe ProbeHeaders(std::string_view headerPrefix, bool isWholeFile);
+
+	// Returned view points into the mapped image and is valid until the reader opens another file or closes
+	std::string_view ReadExportString(std::string_view exportName);
+
+	// Follows a pointer stored in the image, such as a const char* field of an exported struct.
+	// Pointers hold virtual addresses based at the preferred image base, since relocations are only applied when loaded.
+	// Returns nullopt for null pointers, and pointers that do not reach a null terminated string within a section.
+	std::optional<std::string_view> ReadStringAtVirtualAddress(std::uint64_t virtualAddress);
 
 	template <typename DataType>
-	DataType ReadExport(const std::string& exportName)
+	DataType ReadExport(std::string_view exportName)
 	{
 		static_assert(std::is_trivially_copyable_v<DataType>, "Type must be trivially copyable");
 
-		stream.Seek(GetExportedFileOffset(exportName));
+		return ReadAt<DataType>(GetExportedFileOffset(exportName));
+	}
 
-		DataType value;
-		stream.Read(value);
-		return value;
+	// Reads several exports in one pass, such as ReadExports<AIModDesc32, std::string_view>({ "DescBlock", "MapName" }).
+	// A std::string_view type reads a null terminated string, as ReadExportString does.
+	// Names are resolved first, then values are read in file offset order.
+	// Throws on the first export, in the order given, that does not exist.
+	template <typename... DataTypes>
+	std::tuple<DataTypes...> ReadExports(const std::array<std::string_view, sizeof...(DataTypes)>& exportNames)
+	{
+		constexpr auto exportCount = sizeof...(DataTypes);
+
+		std::array<std::size_t, exportCount> fileOffsets;
+		GetExportedFileOffsets(exportNames.data(), fileOffsets.data(), exportCount);
+
+		std::array<std::size_t, exportCount> readOrder;
+		for (std::size_t i = 0; i < exportCount; ++i) {
+			readOrder[i] = i;
+		}
+		std::sort(readOrder.begin(), readOrder.end(), [&fileOffsets](std::size_t a, std::size_t b) {
+			return fileOffsets[a] < fileOffsets[b];
+		});
+
+		std::tuple<DataTypes...> values;
+		for (const auto index : readOrder) {
+			ReadExportValueAt(values, index, fileOffsets[index], std::index_sequence_for<DataTypes...>());
+		}
+		return values;
 	}
 
-	bool DoesExportExist(const std::string& exportName);
+	bool DoesExportExist(std::string_view exportName);
+
+	struct ExportEntry
+	{
+		// Biased by the export directory's ordinalBase, as used by GetProcAddress and module definition files
+		std::uint32_t ordinal;
+
+		// Empty for exports only available by ordinal
+		std::string_view name;
+
+		std::uint32_t rva;
+
+		// Empty if no section contains the RVA
+		std::string_view sectionName;
+
+		// Set for exports forwarded to another DLL, such as "NTDLL.RtlAllocateHeap" or "MYDLL.#27"
+		std::optional<std::string_view> forwarder;
+	};
+
+	// Visits named exports in name table order, then exports only available by ordinal in ordinal order.
+	// An export with several names is visited once per name. Unused address table entries are skipped.
+	// Entries are read as they are visited, and views are valid until the reader opens another file or closes.
+	void ForEachExport(const std::function<void(const ExportEntry& exportEntry)>& visitor);
+
+	// Link time recorded in the COFF header
+	std::uint32_t TimeDateStamp() const { return timeDateStamp; }
+
+	ImageFormat Format() const { return imageFormat; }
+
+	// Digest of the entire file, for recognizing DLLs with identical content. Reads the whole image.
+	ContentDigest DigestImage() const;
+
+	const ImageReadCounters& ReadCounters() const { return readCounters; }
 
 private:
-	Stream::FileReader stream;
+	MappedFile mappedFile;
+	std::vector<char> imageBuffer;
+	std::string_view image;
+	std::uint32_t timeDateStamp = 0;
+	ImageFormat imageFormat = ImageFormat::Other;
+	bool isImageFormatRead = false;
+	std::uint64_t imageBase = 0;
+
+	// Set when the image is only the start of a longer file, while probing headers
+	bool isHeaderPrefix = false;
+	struct HeaderPrefixExhausted { };
 
 	std::vector<SectionTable> sectionTables;
-	std::vector<std::string> exportNameTable;
-	std::vector<std::uint32_t> exportAddressTable;
 
+	SectionTable exportSectionTable{};
+	std::size_t exportNamePointerTableOffset = 0;
+	std::size_t exportAddressTableOffset = 0;
+	std::size_t exportOrdinalTableOffset = 0;
+	std::size_t exportNameCount = 0;
+	std::size_t exportAddressCount = 0;
+	std::uint32_t exportOrdinalBase = 0;
+
+	// Address table RVAs within the export directory refer to forwarder strings rather than code or data
+	ImageDataDirectory exportDirectory{};
+
+	// Marks address table entries reached through a name while visiting exports
+	std::vector<bool> namedExportAddresses;
+
+	// Only loaded if a lookup finds the name pointer table is not sorted. Then holds name table positions ordered by name.
+	std::vector<std::string_view> exportNameTable;
+	std::vector<std::size_t> exportNameIndex;
+
+	mutable ImageReadCounters readCounters;
+	mutable std::size_t nextReadOffset = 0;
+
+	void CountRead(std::size_t offset, std::size_t size) const
+	{
+		if (offset != nextReadOffset) {
+			++readCounters.seekCount;
+		}
+		++readCounters.readCount;
+		readCounters.bytesRead += size;
+		nextReadOffset = offset + size;
+	}
+
+	template <typename DataType>
+	DataType ReadAt(std::size_t offset) const
+	{
+		static_assert(std::is_trivially_copyable_v<DataType>, "Type must be trivially copyable");
+
+		CheckFileRange(offset, sizeof(DataType));
+		CountRead(offset, sizeof(DataType));
+
+		DataType value;
+		std::memcpy(&value, image.data() + offset, sizeof(DataType));
+		return value;
+	}
+
+	// Throws unless size bytes from offset lie within the image
+	void CheckFileRange(std::uint64_t offset, std::uint64_t size) const;
+
+	std::string_view ReadNullTerminatedStringAt(std::size_t offset) const;
+	std::optional<std::string_view> FindNullTerminatedStringAt(std::size_t offset) const;
+
+	// Reads tuple element index, selecting the element type at compile time
+	template <typename... DataTypes, std::size_t... Indexes>
+	void ReadExportValueAt(std::tuple<DataTypes...>& values, std::size_t index, std::size_t offset, std::index_sequence<Indexes...>) const
+	{
+		((index == Indexes ? (std::get<Indexes>(values) = ReadValueAt<DataTypes>(offset), void()) : void()), ...);
+	}
+
+	template <typename DataType>
+	DataType ReadValueAt(std::size_t offset) const
+	{
+		if constexpr (std::is_same_v<DataType, std::string_view>) {
+			return ReadNullTerminatedStringAt(offset);
+		}
+		else {
+			return ReadAt<DataType>(offset);
+		}
+	}
+
+	void Reset(std::string_view newImage);
+	void LoadHeaders();
+	std::optional<ImageDataDirectory> ReadHeaders();
+
+	// Instantiated for Image32Bit and Image64Bit
+	template <typename ImageHeader>
+	std::optional<ImageDataDirectory> ReadOptionalHeader(const CoffHeader& coffHeader, std::size_t optionalHeaderOffset);
+	void LoadExportTable(const ImageDataDirectory& exportTableEntry);
 	bool IsPortableExecutableFile();
 	bool IsDll(const CoffHeader& coffHeader);
 	SectionTable FindSectionTableContainingRva(std::uint32_t rva);
-	void LoadNameTable(std::uint32_t rva, const SectionTable& sectionTable, std::size_t count);
-	std::uint32_t RvaToFileOffset(std::uint32_t rva, const SectionTable& sectionTable);
-	std::size_t GetExportOrdinal(const std::string& exportName);
-	std::uint32_t GetExportedFileOffset(const std::string& exportName);
+	const SectionTable* FindSectionTable(std::uint32_t rva) const;
+	std::string_view ReadExportName(std::size_t index) const;
+	void BuildExportNameIndex();
+	std::optional<std::size_t> FindExportNamePosition(std::string_view exportName);
+	std::optional<std::size_t> FindExportNamePositionInIndex(std::string_view exportName) const;
+	std::size_t RvaToFileOffset(std::uint32_t rva, const SectionTable& sectionTable, std::uint64_t size) const;
+	std::size_t GetExportNamePosition(std::string_view exportName);
+	std::size_t GetExportedFileOffset(std::string_view exportName);
+	void GetExportedFileOffsets(const std::string_view* exportNames, std::size_t* fileOffsets, std::size_t count);
+	std::size_t GetExportAddressIndex(std::size_t namePosition) const;
+	std::uint32_t ReadExportAddress(std::size_t index) const;
+	bool IsForwarderRva(std::uint32_t rva) const;
+	ExportEntry ReadExportEntry(std::size_t addressIndex, std::string_view name) const;
+	static bool SectionContainsRva(const SectionTable& sectionTable, std::uint32_t rva);
 };
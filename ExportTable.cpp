@@ -0,0 +1,180 @@
+#include "ExportTable.h"
+#include "DllExportReader32.h"
+#include "MissionArchive.h"
+#include "OutputBuffer.h"
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+
+
+void WriteExportHeader(OutputBuffer& output, OutputFormat outputFormat);
+void WriteDllHeader(OutputBuffer& output, OutputFormat outputFormat, const std::string& dllPath);
+void WriteExportEntry(OutputBuffer& output, OutputFormat outputFormat, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry);
+void WriteTextExportEntry(OutputBuffer& output, const DllExportReader32::ExportEntry& exportEntry);
+void WriteCsvExportEntry(OutputBuffer& output, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry);
+void WriteJsonExportEntry(OutputBuffer& output, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry);
+
+constexpr std::size_t ordinalWidth = 9;
+constexpr std::size_t rvaWidth = 10;
+constexpr std::size_t sectionWidth = 10;
+
+
+void WriteExportTable(std::vector<std::string> dllPaths, const ScanOptions& scanOptions)
+{
+	std::sort(dllPaths.begin(), dllPaths.end());
+
+	WriteExportTable([&dllPaths](const MissionPathSink& addDllPath) {
+		for (auto& dllPath : dllPaths) {
+			addDllPath(std::move(dllPath));
+		}
+	}, scanOptions);
+}
+
+void WriteExportTable(const MissionPathSource& dllPathSource, const ScanOptions& scanOptions)
+{
+	if (scanOptions.outputFormat == OutputFormat::Binary) {
+		throw std::runtime_error("Export listing does not support binary output");
+	}
+
+	OutputBuffer output(std::cout);
+	DllExportReader32 dllReader;
+	bool isHeaderWritten = false;
+
+	dllPathSource([&](std::string dllPath) {
+		// Nothing is written unless at least one DLL was found
+		if (!isHeaderWritten) {
+			WriteExportHeader(output, scanOptions.outputFormat);
+			isHeaderWritten = true;
+		}
+
+		try {
+			OpenMissionDll(dllPath, dllReader);
+			if (dllReader.Format() == DllExportReader32::ImageFormat::Other) {
+				throw std::runtime_error("Unsupported optional header : Only PE32 and PE32+ exports can be listed");
+			}
+			WriteDllHeader(output, scanOptions.outputFormat, dllPath);
+			dllReader.ForEachExport([&](const DllExportReader32::ExportEntry& exportEntry) {
+				WriteExportEntry(output, scanOptions.outputFormat, dllPath, exportEntry);
+			});
+		}
+		catch (const std::exception& e) {
+			output.Flush();
+			std::cerr << "Error reading exports of DLL: " << dllPath << " : " << e.what() << std::endl;
+		}
+
+		dllReader.Close();
+	});
+
+	output.Flush();
+	std::cout.flush();
+}
+
+
+void WriteExportHeader(OutputBuffer& output, OutputFormat outputFormat)
+{
+	if (outputFormat == OutputFormat::Csv) {
+		output.Write("path,ordinal,name,rva,section,forwarder");
+		output.EndLine();
+	}
+}
+
+// Text output groups each DLL's exports under its path
+void WriteDllHeader(OutputBuffer& output, OutputFormat outputFormat, const std::string& dllPath)
+{
+	if (outputFormat != OutputFormat::Text) {
+		return;
+	}
+
+	output.EndLine();
+	output.Write(dllPath);
+	output.EndLine();
+	output.WritePadded("ORDINAL", ordinalWidth);
+	output.WritePadded("RVA", rvaWidth);
+	output.WritePadded("SECTION", sectionWidth);
+	output.Write("NAME");
+	output.EndLine();
+}
+
+void WriteExportEntry(OutputBuffer& output, OutputFormat outputFormat, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry)
+{
+	switch (outputFormat)
+	{
+	case OutputFormat::Csv:
+		WriteCsvExportEntry(output, dllPath, exportEntry);
+		break;
+	case OutputFormat::JsonLines:
+		WriteJsonExportEntry(output, dllPath, exportEntry);
+		break;
+	default:
+		WriteTextExportEntry(output, exportEntry);
+		break;
+	}
+	output.EndLine();
+}
+
+// Exports only available by ordinal are named by ordinal, and forwarders follow an arrow
+void WriteTextExportEntry(OutputBuffer& output, const DllExportReader32::ExportEntry& exportEntry)
+{
+	output.WriteInteger(exportEntry.ordinal, ordinalWidth);
+	output.WriteHex(exportEntry.rva, 8);
+	output.WritePadded("", rvaWidth - 8);
+	output.WritePadded(exportEntry.sectionName, sectionWidth);
+
+	if (exportEntry.name.empty()) {
+		output.Write("[NONAME]");
+	}
+	else {
+		output.Write(exportEntry.name);
+	}
+
+	if (exportEntry.forwarder) {
+		output.Write(" -> ");
+		output.Write(*exportEntry.forwarder);
+	}
+}
+
+// Empty name and forwarder fields for exports without them. RVA is written in hexadecimal with a 0x prefix.
+void WriteCsvExportEntry(OutputBuffer& output, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry)
+{
+	WriteCsvField(output, dllPath);
+	output.Write(',');
+	output.WriteInteger(exportEntry.ordinal);
+	output.Write(',');
+	WriteCsvField(output, exportEntry.name);
+	output.Write(",0x");
+	output.WriteHex(exportEntry.rva, 8);
+	output.Write(',');
+	WriteCsvField(output, exportEntry.sectionName);
+	output.Write(',');
+	if (exportEntry.forwarder) {
+		WriteCsvField(output, *exportEntry.forwarder);
+	}
+}
+
+// Name and forwarder are null for exports without them, and section is null when no section contains the RVA
+void WriteJsonExportEntry(OutputBuffer& output, const std::string& dllPath, const DllExportReader32::ExportEntry& exportEntry)
+{
+	const auto writeOptionalString = [&output](std::string_view value, bool isPresent) {
+		if (isPresent) {
+			WriteJsonString(output, value);
+		}
+		else {
+			output.Write("null");
+		}
+	};
+
+	output.Write("{\"path\":");
+	WriteJsonString(output, dllPath);
+	output.Write(",\"ordinal\":");
+	output.WriteInteger(exportEntry.ordinal);
+	output.Write(",\"name\":");
+	writeOptionalString(exportEntry.name, !exportEntry.name.empty());
+	output.Write(",\"rva\":");
+	output.WriteInteger(exportEntry.rva);
+	output.Write(",\"section\":");
+	writeOptionalString(exportEntry.sectionName, !exportEntry.sectionName.empty());
+	output.Write(",\"forwarder\":");
+	writeOptionalString(exportEntry.forwarder.value_or(std::string_view()), exportEntry.forwarder.has_value());
+	output.Write('}');
+}
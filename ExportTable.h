@@ -0,0 +1,15 @@
+#pragma once
+
+#include "MissionTable.h"
+#include <string>
+#include <vector>
+
+
+// Lists every export of each DLL (--exports), instead of the mission table.
+// Each DLL's exports are written as they are read, so large export tables are not held in memory.
+// DLLs are read one at a time, in the order the source supplies them. Binary output is not supported.
+
+// Sorts paths before writing
+void WriteExportTable(std::vector<std::string> dllPaths, const ScanOptions& scanOptions);
+
+void WriteExportTable(const MissionPathSource& dllPathSource, const ScanOptions& scanOptions);
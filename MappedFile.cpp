@@ -0,0 +1,180 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <utility>
+#include <cerrno>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Unable to open file : " + filename);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		throw std::runtime_error("Unable to determine size of file : " + filename);
+	}
+
+	// Zero length files can not be mapped, and are represented by an empty view
+	if (fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		throw std::runtime_error("Unable to map file : " + filename);
+	}
+
+	// The view keeps a reference to the mapping object, so the handle can be closed immediately
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (view == nullptr) {
+		throw std::runtime_error("Unable to map file : " + filename);
+	}
+
+	data = static_cast<const char*>(view);
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+}
+
+void MappedFile::Close()
+{
+	if (data != nullptr) {
+		UnmapViewOfFile(data);
+	}
+	data = nullptr;
+	size = 0;
+}
+
+std::optional<std::size_t> ReadFilePrefix(const std::string& filename, char* buffer, std::size_t size)
+{
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return std::nullopt;
+	}
+
+	// Network filesystems may return less than requested before the end of the file, so read until full or at the end
+	std::size_t totalBytesRead = 0;
+	while (totalBytesRead < size) {
+		DWORD bytesRead = 0;
+		if (!ReadFile(file, buffer + totalBytesRead, static_cast<DWORD>(size - totalBytesRead), &bytesRead, nullptr)) {
+			CloseHandle(file);
+			return std::nullopt;
+		}
+		if (bytesRead == 0) {
+			break;
+		}
+		totalBytesRead += bytesRead;
+	}
+
+	CloseHandle(file);
+	return totalBytesRead;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	const int fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor == -1) {
+		throw std::runtime_error("Unable to open file : " + filename);
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) == -1) {
+		close(fileDescriptor);
+		throw std::runtime_error("Unable to determine size of file : " + filename);
+	}
+
+	// Zero length files can not be mapped, and are represented by an empty view
+	if (fileStatus.st_size == 0) {
+		close(fileDescriptor);
+		return;
+	}
+
+	// The mapping keeps its own reference to the file, so the descriptor can be closed immediately
+	void* view = mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (view == MAP_FAILED) {
+		throw std::runtime_error("Unable to map file : " + filename);
+	}
+
+	data = static_cast<const char*>(view);
+	size = static_cast<std::size_t>(fileStatus.st_size);
+}
+
+void MappedFile::Close()
+{
+	if (data != nullptr) {
+		munmap(const_cast<char*>(data), size);
+	}
+	data = nullptr;
+	size = 0;
+}
+
+std::optional<std::size_t> ReadFilePrefix(const std::string& filename, char* buffer, std::size_t size)
+{
+	const int fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor == -1) {
+		return std::nullopt;
+	}
+
+	// Network filesystems may return less than requested before the end of the file, so read until full or at the end
+	std::size_t totalBytesRead = 0;
+	while (totalBytesRead < size) {
+		const auto bytesRead = read(fileDescriptor, buffer + totalBytesRead, size - totalBytesRead);
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead < 0) {
+			close(fileDescriptor);
+			return std::nullopt;
+		}
+		if (bytesRead == 0) {
+			break;
+		}
+		totalBytesRead += static_cast<std::size_t>(bytesRead);
+	}
+
+	close(fileDescriptor);
+	return totalBytesRead;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	data(std::exchange(other.data, nullptr)),
+	size(std::exchange(other.size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		Close();
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+	}
+	return *this;
+}
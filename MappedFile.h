@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <optional>
+
+
+// Read-only view of an entire file's contents, memory mapped by the operating system
+// Reads are served by the page cache, so no per-field Seek/Read calls are issued
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	std::string_view View() const { return std::string_view(data, size); }
+	std::size_t Size() const { return size; }
+
+private:
+	const char* data = nullptr;
+	std::size_t size = 0;
+
+	void Close();
+};
+
+// Reads up to size bytes from the start of a file without allocating, repeating short reads until the buffer is full or the file ends.
+// Returns the number of bytes read, which is less than size only when the end of the file was reached, or nullopt if the file can not be read.
+std::optional<std::size_t> ReadFilePrefix(const std::string& filename, char* buffer, std::size_t size);
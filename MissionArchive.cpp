@@ -0,0 +1,131 @@
+#include "MissionArchive.h"
+#include "OP2Utility.h"
+#include <memory>
+#include <array>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+bool HasExtension(const fs::path& path, std::string_view extension);
+Archive::ArchiveFile& OpenArchive(const std::string& archivePath);
+std::size_t FindArchiveEntry(Archive::ArchiveFile& archive, const std::string& entryName);
+
+
+bool IsArchiveFile(const std::string& path)
+{
+	return (HasExtension(path, ".vol") || HasExtension(path, ".clm")) && fs::is_regular_file(path);
+}
+
+std::optional<ArchivedPath> SplitArchivedPath(const std::string& path)
+{
+	const fs::path fsPath(path);
+	const auto parentPath = fsPath.parent_path().string();
+
+	if (parentPath.empty() || !IsArchiveFile(parentPath)) {
+		return std::nullopt;
+	}
+
+	return ArchivedPath{ parentPath, fsPath.filename().string() };
+}
+
+std::vector<std::string> FindArchivedMissionPaths(const std::string& archivePath)
+{
+	auto& archive = OpenArchive(archivePath);
+
+	std::vector<std::string> missionPaths;
+	for (std::size_t i = 0; i < archive.GetCount(); ++i) {
+		const auto entryName = archive.GetName(i);
+		if (HasExtension(entryName, ".dll")) {
+			missionPaths.push_back(XFile::Append(archivePath, entryName));
+		}
+	}
+
+	return missionPaths;
+}
+
+void OpenMissionDll(const std::string& missionPath, DllExportReader32& dllReader)
+{
+	const auto archivedPath = SplitArchivedPath(missionPath);
+	if (!archivedPath) {
+		dllReader.Open(missionPath);
+		return;
+	}
+
+	auto& archive = OpenArchive(archivedPath->archivePath);
+	auto stream = archive.OpenStream(FindArchiveEntry(archive, archivedPath->entryName));
+	dllReader.Open(*stream);
+}
+
+DllExportReader32::HeaderProbe ProbeMissionDll(const std::string& missionPath, DllExportReader32& dllReader)
+{
+	const DllExportReader32::HeaderProbe notProbed{ true, 0, {}, std::nullopt };
+
+	if (SplitArchivedPath(missionPath)) {
+		return notProbed;
+	}
+
+	std::array<char, DllExportReader32::headerProbeSize> headerPrefix;
+	const auto prefixSize = ReadFilePrefix(missionPath, headerPrefix.data(), headerPrefix.size());
+	if (!prefixSize) {
+		return notProbed; // Leave reporting the error to the full reader
+	}
+
+	return ProbeMissionHeaders(std::string_view(headerPrefix.data(), *prefixSize), dllReader);
+}
+
+DllExportReader32::HeaderProbe ProbeMissionHeaders(std::string_view headerPrefix, DllExportReader32& dllReader)
+{
+	return dllReader.ProbeHeaders(headerPrefix, headerPrefix.size() < DllExportReader32::headerProbeSize);
+}
+
+
+bool HasExtension(const fs::path& path, std::string_view extension)
+{
+	const auto pathExtension = path.extension().string();
+
+	return std::equal(pathExtension.begin(), pathExtension.end(), extension.begin(), extension.end(),
+		[](char a, char b) {
+			return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+		});
+}
+
+// Entries are usually scanned in path order, so consecutive entries share an archive.
+// Keep the most recently used archive open per thread, rather than re-reading its index for every entry.
+Archive::ArchiveFile& OpenArchive(const std::string& archivePath)
+{
+	thread_local std::string openArchivePath;
+	thread_local std::unique_ptr<Archive::ArchiveFile> openArchive;
+
+	if (!openArchive || openArchivePath != archivePath) {
+		openArchive.reset();
+		if (HasExtension(archivePath, ".clm")) {
+			openArchive = std::make_unique<Archive::ClmFile>(archivePath);
+		}
+		else {
+			openArchive = std::make_unique<Archive::VolFile>(archivePath);
+		}
+		openArchivePath = archivePath;
+	}
+
+	return *openArchive;
+}
+
+std::size_t FindArchiveEntry(Archive::ArchiveFile& archive, const std::string& entryName)
+{
+	for (std::size_t i = 0; i < archive.GetCount(); ++i) {
+		if (archive.GetName(i) == entryName) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Archive does not contain file : " + entryName);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "DllExportReader32.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+
+
+// Mission DLLs packed inside an archive are addressed as if the archive were a directory,
+// for example "maps.vol/ml6_21.dll"
+
+struct ArchivedPath
+{
+	std::string archivePath;
+	std::string entryName;
+};
+
+bool IsArchiveFile(const std::string& path);
+
+// Returns nullopt if the path does not refer to an entry inside an archive file
+std::optional<ArchivedPath> SplitArchivedPath(const std::string& path);
+
+std::vector<std::string> FindArchivedMissionPaths(const std::string& archivePath);
+
+// Opens the reader directly on the archive bytes, or from disk for plain paths
+void OpenMissionDll(const std::string& missionPath, DllExportReader32& dllReader);
+
+// Checks headers from a single read of the start of a plain file, before the whole file is opened.
+// Archived DLLs and files that can not be read are not probed, and are reported as having an export table.
+DllExportReader32::HeaderProbe ProbeMissionDll(const std::string& missionPath, DllExportReader32& dllReader);
+
+// Checks headers from a prefix of a plain file already read, of up to DllExportReader32::headerProbeSize bytes
+DllExportReader32::HeaderProbe ProbeMissionHeaders(std::string_view headerPrefix, DllExportReader32& dllReader);
@@ -0,0 +1,120 @@
+#include "MissionCatalog.h"
+#include "MissionTable.h"
+#include <algorithm>
+#include <cctype>
+
+
+std::string ToLowerCase(std::string_view text);
+const std::vector<std::uint32_t>* FindIndices(const std::map<int, std::vector<std::uint32_t>>& index, int key);
+
+
+MissionCatalog::MissionCatalog(std::vector<MissionRow> rows) :
+	rows(std::move(rows))
+{
+	jsonOffsets.reserve(this->rows.size() + 1);
+	jsonOffsets.push_back(0);
+
+	for (std::uint32_t rowIndex = 0; rowIndex < this->rows.size(); ++rowIndex) {
+		const auto& row = this->rows[rowIndex];
+
+		jsonLines += FormatJsonLine(row);
+		jsonOffsets.push_back(jsonLines.size());
+
+		rowsByName[ToLowerCase(row.filename)].push_back(rowIndex);
+		if (row.aiModDesc) {
+			rowsByMissionType[row.aiModDesc->missionType].push_back(rowIndex);
+			rowsByNumPlayers[row.aiModDesc->numPlayers].push_back(rowIndex);
+		}
+	}
+
+	jsonLines.shrink_to_fit();
+}
+
+std::size_t MissionCatalog::AppendMatches(const MissionFilter& missionFilter, std::string& response) const
+{
+	std::size_t matchCount = 0;
+	const auto appendIfMatched = [&](std::size_t rowIndex) {
+		if (missionFilter.Matches(rows[rowIndex])) {
+			AppendJsonLine(rowIndex, response);
+			++matchCount;
+		}
+	};
+
+	const auto* candidates = FindCandidates(missionFilter);
+	if (candidates != nullptr) {
+		for (const auto rowIndex : *candidates) {
+			appendIfMatched(rowIndex);
+		}
+	}
+	else {
+		for (std::size_t rowIndex = 0; rowIndex < rows.size(); ++rowIndex) {
+			appendIfMatched(rowIndex);
+		}
+	}
+
+	return matchCount;
+}
+
+std::size_t MissionCatalog::AppendNamed(std::string_view name, std::string& response) const
+{
+	const auto named = rowsByName.find(ToLowerCase(name));
+	if (named == rowsByName.end()) {
+		return 0;
+	}
+
+	for (const auto rowIndex : named->second) {
+		AppendJsonLine(rowIndex, response);
+	}
+	return named->second.size();
+}
+
+// Smallest index list selected by an = condition, or nullptr if every row must be tested.
+// Candidates are in catalog order, and still need matching against the rest of the filter.
+const MissionCatalog::RowIndices* MissionCatalog::FindCandidates(const MissionFilter& missionFilter) const
+{
+	static const RowIndices noRows;
+
+	std::vector<const RowIndices*> indexMatches;
+
+	if (const auto name = missionFilter.FindEqualString(MissionField::Name)) {
+		const auto named = rowsByName.find(ToLowerCase(*name));
+		indexMatches.push_back(named != rowsByName.end() ? &named->second : &noRows);
+	}
+	if (const auto missionType = missionFilter.FindEqualInteger(MissionField::MissionType)) {
+		const auto* indices = FindIndices(rowsByMissionType, *missionType);
+		indexMatches.push_back(indices != nullptr ? indices : &noRows);
+	}
+	if (const auto numPlayers = missionFilter.FindEqualInteger(MissionField::NumPlayers)) {
+		const auto* indices = FindIndices(rowsByNumPlayers, *numPlayers);
+		indexMatches.push_back(indices != nullptr ? indices : &noRows);
+	}
+
+	if (indexMatches.empty()) {
+		return nullptr;
+	}
+
+	return *std::min_element(indexMatches.begin(), indexMatches.end(), [](const RowIndices* a, const RowIndices* b) {
+		return a->size() < b->size();
+	});
+}
+
+void MissionCatalog::AppendJsonLine(std::size_t rowIndex, std::string& response) const
+{
+	response.append(jsonLines, jsonOffsets[rowIndex], jsonOffsets[rowIndex + 1] - jsonOffsets[rowIndex]);
+}
+
+
+std::string ToLowerCase(std::string_view text)
+{
+	std::string lowerCase(text);
+	std::transform(lowerCase.begin(), lowerCase.end(), lowerCase.begin(), [](unsigned char character) {
+		return static_cast<char>(std::tolower(character));
+	});
+	return lowerCase;
+}
+
+const std::vector<std::uint32_t>* FindIndices(const std::map<int, std::vector<std::uint32_t>>& index, int key)
+{
+	const auto indices = index.find(key);
+	return indices != index.end() ? &indices->second : nullptr;
+}
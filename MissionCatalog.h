@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MissionRow.h"
+#include "MissionQuery.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+
+
+// Scanned missions held in memory for --serve, with each row's JSON line rendered once when built.
+// Rows are indexed by name, missionType and numPlayers, so common lookups do not test every row.
+// Never changed once built, so any number of threads may query it while a rescan builds its replacement.
+class MissionCatalog
+{
+public:
+	// Rows are kept in the order given
+	explicit MissionCatalog(std::vector<MissionRow> rows);
+
+	std::size_t Size() const { return rows.size(); }
+
+	// Appends the JSON line of each row matching the filter, returning the number of rows appended
+	std::size_t AppendMatches(const MissionFilter& missionFilter, std::string& response) const;
+
+	// Appends the JSON line of each DLL with the name, ignoring case. Names repeat when several directories are scanned.
+	std::size_t AppendNamed(std::string_view name, std::string& response) const;
+
+private:
+	using RowIndices = std::vector<std::uint32_t>;
+
+	std::vector<MissionRow> rows;
+
+	// JSON line of row i is jsonLines[jsonOffsets[i], jsonOffsets[i + 1])
+	std::string jsonLines;
+	std::vector<std::size_t> jsonOffsets;
+
+	// Keys are lower case names
+	std::unordered_map<std::string, RowIndices> rowsByName;
+	std::map<int, RowIndices> rowsByMissionType;
+	std::map<int, RowIndices> rowsByNumPlayers;
+
+	const RowIndices* FindCandidates(const MissionFilter& missionFilter) const;
+	void AppendJsonLine(std::size_t rowIndex, std::string& response) const;
+};
@@ -0,0 +1,380 @@
+#include "MissionQuery.h"
+#include "MissionTable.h"
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+
+struct MissionFieldName
+{
+	std::string_view name;
+	MissionField field;
+};
+
+constexpr std::array<MissionFieldName, 10> missionFieldNames{
+	MissionFieldName {"path", MissionField::Path},
+	MissionFieldName {"name", MissionField::Name},
+	MissionFieldName {"missionType", MissionField::MissionType},
+	MissionFieldName {"numPlayers", MissionField::NumPlayers},
+	MissionFieldName {"maxTechLevel", MissionField::MaxTechLevel},
+	MissionFieldName {"boolUnitMission", MissionField::BoolUnitMission},
+	MissionFieldName {"checksum", MissionField::Checksum},
+	MissionFieldName {"mapName", MissionField::MapName},
+	MissionFieldName {"techtreeName", MissionField::TechtreeName},
+	MissionFieldName {"levelDesc", MissionField::LevelDesc}
+};
+
+bool IsStringField(MissionField field);
+bool IsReadBeforeStrings(MissionField field);
+std::optional<int> GetIntegerField(const MissionRow& row, MissionField field);
+const std::string* GetStringField(const MissionRow& row, MissionField field);
+int CompareFields(const MissionRow& a, const MissionRow& b, MissionField field);
+std::optional<int> ParseInteger(const std::string& value);
+bool IsMissionTypeKey(std::string_view value);
+int CompareIgnoringCase(std::string_view a, std::string_view b);
+bool ContainsIgnoringCase(std::string_view text, std::string_view part);
+std::string_view TrimSpaces(std::string_view text);
+
+
+MissionField ParseMissionField(std::string_view fieldName)
+{
+	for (const auto& missionFieldName : missionFieldNames) {
+		if (CompareIgnoringCase(missionFieldName.name, fieldName) == 0) {
+			return missionFieldName.field;
+		}
+	}
+
+	throw std::runtime_error("Unknown mission field : " + std::string(fieldName));
+}
+
+void MissionFilter::AddCondition(std::string_view expression)
+{
+	const auto operatorOffset = expression.find_first_of("!<>=~");
+	if (operatorOffset == std::string_view::npos) {
+		throw std::runtime_error("Missing operator in condition : " + std::string(expression));
+	}
+
+	Condition condition;
+	condition.field = ParseMissionField(TrimSpaces(expression.substr(0, operatorOffset)));
+
+	const bool isFollowedByEqual = operatorOffset + 1 < expression.size() && expression[operatorOffset + 1] == '=';
+	std::size_t operatorSize = 1;
+	switch (expression[operatorOffset])
+	{
+	case '!':
+		if (!isFollowedByEqual) {
+			throw std::runtime_error("Unknown operator in condition : " + std::string(expression));
+		}
+		condition.op = Operator::NotEqual;
+		operatorSize = 2;
+		break;
+	case '<':
+		condition.op = isFollowedByEqual ? Operator::LessOrEqual : Operator::Less;
+		operatorSize = isFollowedByEqual ? 2 : 1;
+		break;
+	case '>':
+		condition.op = isFollowedByEqual ? Operator::GreaterOrEqual : Operator::Greater;
+		operatorSize = isFollowedByEqual ? 2 : 1;
+		break;
+	case '~':
+		condition.op = Operator::Contains;
+		break;
+	default:
+		condition.op = Operator::Equal;
+		break;
+	}
+
+	// Spaces within string values are kept, as descriptions contain them
+	condition.value = std::string(expression.substr(operatorOffset + operatorSize));
+
+	if (!IsStringField(condition.field)) {
+		if (condition.op == Operator::Contains) {
+			throw std::runtime_error("Contains operator only applies to string fields : " + std::string(expression));
+		}
+
+		condition.integer = ParseInteger(condition.value);
+		const bool isMissionTypeKey = !condition.integer && condition.field == MissionField::MissionType &&
+			(condition.op == Operator::Equal || condition.op == Operator::NotEqual) && IsMissionTypeKey(condition.value);
+		if (!condition.integer && !isMissionTypeKey) {
+			throw std::runtime_error("Invalid integer in condition : " + std::string(expression));
+		}
+	}
+
+	conditions.push_back(std::move(condition));
+}
+
+bool MissionFilter::UsesField(MissionField field) const
+{
+	return std::any_of(conditions.begin(), conditions.end(), [field](const Condition& condition) {
+		return condition.field == field;
+	});
+}
+
+bool MissionFilter::MatchesBeforeStrings(const MissionRow& row) const
+{
+	return std::all_of(conditions.begin(), conditions.end(), [&row](const Condition& condition) {
+		return !IsReadBeforeStrings(condition.field) || Matches(condition, row);
+	});
+}
+
+bool MissionFilter::Matches(const MissionRow& row) const
+{
+	return std::all_of(conditions.begin(), conditions.end(), [&row](const Condition& condition) {
+		return Matches(condition, row);
+	});
+}
+
+std::optional<int> MissionFilter::FindEqualInteger(MissionField field) const
+{
+	for (const auto& condition : conditions) {
+		if (condition.field == field && condition.op == Operator::Equal && condition.integer) {
+			return condition.integer;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<std::string_view> MissionFilter::FindEqualString(MissionField field) const
+{
+	for (const auto& condition : conditions) {
+		if (condition.field == field && condition.op == Operator::Equal && IsStringField(field)) {
+			return std::string_view(condition.value);
+		}
+	}
+
+	return std::nullopt;
+}
+
+bool MissionFilter::Matches(const Condition& condition, const MissionRow& row)
+{
+	if (IsStringField(condition.field)) {
+		const auto* value = GetStringField(row, condition.field);
+		if (value == nullptr) {
+			return false;
+		}
+		if (condition.op == Operator::Contains) {
+			return ContainsIgnoringCase(*value, condition.value);
+		}
+		return Compare(condition.op, CompareIgnoringCase(*value, condition.value));
+	}
+
+	const auto value = GetIntegerField(row, condition.field);
+	if (!value) {
+		return false;
+	}
+
+	if (!condition.integer) {
+		try {
+			const auto key = ConvertMissionTypeToString(static_cast<MissionTypes>(*value));
+			return Compare(condition.op, CompareIgnoringCase(key, condition.value));
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+	}
+
+	return Compare(condition.op, (*value > *condition.integer) - (*value < *condition.integer));
+}
+
+bool MissionFilter::Compare(Operator op, int comparison)
+{
+	switch (op)
+	{
+	case Operator::Equal:
+		return comparison == 0;
+	case Operator::NotEqual:
+		return comparison != 0;
+	case Operator::Less:
+		return comparison < 0;
+	case Operator::LessOrEqual:
+		return comparison <= 0;
+	case Operator::Greater:
+		return comparison > 0;
+	case Operator::GreaterOrEqual:
+		return comparison >= 0;
+	default:
+		return false;
+	}
+}
+
+
+void MissionSortOrder::AddKeys(std::string_view keyList)
+{
+	while (true) {
+		const auto separatorOffset = keyList.find(',');
+		auto keyName = TrimSpaces(keyList.substr(0, separatorOffset));
+
+		const bool isDescending = !keyName.empty() && keyName[0] == '-';
+		if (isDescending) {
+			keyName.remove_prefix(1);
+		}
+		keys.push_back(SortKey{ ParseMissionField(keyName), isDescending });
+
+		if (separatorOffset == std::string_view::npos) {
+			return;
+		}
+		keyList.remove_prefix(separatorOffset + 1);
+	}
+}
+
+bool MissionSortOrder::IsBefore(const MissionRow& a, const MissionRow& b) const
+{
+	for (const auto& key : keys) {
+		const auto comparison = CompareFields(a, b, key.field);
+		if (comparison != 0) {
+			return key.isDescending ? comparison > 0 : comparison < 0;
+		}
+	}
+
+	return false;
+}
+
+
+bool IsStringField(MissionField field)
+{
+	switch (field)
+	{
+	case MissionField::Path:
+	case MissionField::Name:
+	case MissionField::MapName:
+	case MissionField::TechtreeName:
+	case MissionField::LevelDesc:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool IsReadBeforeStrings(MissionField field)
+{
+	return !IsStringField(field) || field == MissionField::Path || field == MissionField::Name;
+}
+
+std::optional<int> GetIntegerField(const MissionRow& row, MissionField field)
+{
+	if (!row.aiModDesc) {
+		return std::nullopt;
+	}
+
+	switch (field)
+	{
+	case MissionField::MissionType:
+		return row.aiModDesc->missionType;
+	case MissionField::NumPlayers:
+		return row.aiModDesc->numPlayers;
+	case MissionField::MaxTechLevel:
+		return row.aiModDesc->maxTechLevel;
+	case MissionField::BoolUnitMission:
+		return row.aiModDesc->boolUnitMission;
+	case MissionField::Checksum:
+		return row.aiModDesc->checksum;
+	default:
+		return std::nullopt;
+	}
+}
+
+// Returns nullptr when the string was not read
+const std::string* GetStringField(const MissionRow& row, MissionField field)
+{
+	const std::optional<std::string>* value = nullptr;
+	switch (field)
+	{
+	case MissionField::Path:
+		return &row.path;
+	case MissionField::Name:
+		return &row.filename;
+	case MissionField::MapName:
+		value = &row.mapName;
+		break;
+	case MissionField::TechtreeName:
+		value = &row.techtreeName;
+		break;
+	case MissionField::LevelDesc:
+		value = &row.levelDesc;
+		break;
+	default:
+		return nullptr;
+	}
+
+	return *value ? &**value : nullptr;
+}
+
+int CompareFields(const MissionRow& a, const MissionRow& b, MissionField field)
+{
+	if (IsStringField(field)) {
+		const auto* valueA = GetStringField(a, field);
+		const auto* valueB = GetStringField(b, field);
+		if (valueA == nullptr || valueB == nullptr) {
+			return (valueA != nullptr) - (valueB != nullptr);
+		}
+		return CompareIgnoringCase(*valueA, *valueB);
+	}
+
+	const auto valueA = GetIntegerField(a, field);
+	const auto valueB = GetIntegerField(b, field);
+	if (!valueA || !valueB) {
+		return valueA.has_value() - valueB.has_value();
+	}
+	return (*valueA > *valueB) - (*valueA < *valueB);
+}
+
+std::optional<int> ParseInteger(const std::string& value)
+{
+	std::size_t charsProcessed = 0;
+	try {
+		const auto integer = std::stoi(value, &charsProcessed);
+		if (charsProcessed == value.size()) {
+			return integer;
+		}
+	}
+	catch (const std::exception&) {
+	}
+
+	return std::nullopt;
+}
+
+// Campaign missions share a key, so only the first campaign mission number is checked
+bool IsMissionTypeKey(std::string_view value)
+{
+	for (int missionType = 1; missionType >= MultiLastOneStanding; --missionType) {
+		if (missionType != 0 && CompareIgnoringCase(ConvertMissionTypeToString(static_cast<MissionTypes>(missionType)), value) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int CompareIgnoringCase(std::string_view a, std::string_view b)
+{
+	const auto mismatch = std::mismatch(a.begin(), a.end(), b.begin(), b.end(), [](char charA, char charB) {
+		return std::tolower(static_cast<unsigned char>(charA)) == std::tolower(static_cast<unsigned char>(charB));
+	});
+
+	if (mismatch.first == a.end() || mismatch.second == b.end()) {
+		return (mismatch.first != a.end()) - (mismatch.second != b.end());
+	}
+
+	const auto lowerA = std::tolower(static_cast<unsigned char>(*mismatch.first));
+	const auto lowerB = std::tolower(static_cast<unsigned char>(*mismatch.second));
+	return (lowerA > lowerB) - (lowerA < lowerB);
+}
+
+bool ContainsIgnoringCase(std::string_view text, std::string_view part)
+{
+	return part.empty() || std::search(text.begin(), text.end(), part.begin(), part.end(), [](char charText, char charPart) {
+		return std::tolower(static_cast<unsigned char>(charText)) == std::tolower(static_cast<unsigned char>(charPart));
+	}) != text.end();
+}
+
+std::string_view TrimSpaces(std::string_view text)
+{
+	const auto start = text.find_first_not_of(' ');
+	if (start == std::string_view::npos) {
+		return std::string_view();
+	}
+
+	return text.substr(start, text.find_last_not_of(' ') - start + 1);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "MissionRow.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+
+
+// Mission table fields that rows can be filtered and sorted on, named as in csv and jsonl output
+enum class MissionField
+{
+	Path,
+	Name,
+	MissionType,
+	NumPlayers,
+	MaxTechLevel,
+	BoolUnitMission,
+	Checksum,
+	MapName,
+	TechtreeName,
+	LevelDesc,
+};
+
+// Names are not case sensitive. Throws if the name does not match a field.
+MissionField ParseMissionField(std::string_view fieldName);
+
+// Conditions from --where switches, all of which must match for a row to be written.
+// String comparisons ignore case, as Outpost 2 does for file names.
+// A condition on a field missing from the row, because of a read error, does not match.
+class MissionFilter
+{
+public:
+	// Field name, operator and value, such as numPlayers>=4, mapName=cm01.map or levelDesc~colony.
+	// Operators are = != < <= > >= and ~ (contains, strings only).
+	// missionType also accepts a key from the mission type legend, such as missionType=ML.
+	// Throws if the expression can not be parsed.
+	void AddCondition(std::string_view expression);
+
+	bool IsEmpty() const { return conditions.empty(); }
+
+	// True if a condition tests the field, so the field must be read before the row can be matched
+	bool UsesField(MissionField field) const;
+
+	// Tests only conditions on the path, name and AIModDesc, which are known before any strings are read
+	bool MatchesBeforeStrings(const MissionRow& row) const;
+
+	bool Matches(const MissionRow& row) const;
+
+	// Value of an = condition on the field, so callers can narrow rows with an index before matching.
+	// Empty if no such condition, or if missionType is tested with a legend key.
+	std::optional<int> FindEqualInteger(MissionField field) const;
+	std::optional<std::string_view> FindEqualString(MissionField field) const;
+
+private:
+	enum class Operator
+	{
+		Equal,
+		NotEqual,
+		Less,
+		LessOrEqual,
+		Greater,
+		GreaterOrEqual,
+		Contains,
+	};
+
+	struct Condition
+	{
+		MissionField field;
+		Operator op;
+		std::string value;
+
+		// Parsed value for integer fields. Empty when matching a mission type legend key.
+		std::optional<int> integer;
+	};
+
+	std::vector<Condition> conditions;
+
+	static bool Matches(const Condition& condition, const MissionRow& row);
+	static bool Compare(Operator op, int comparison);
+};
+
+// Keys from --sort-by, compared in order. Rows equal on every key keep the order they were found in.
+// Rows missing a field sort before rows that have it.
+class MissionSortOrder
+{
+public:
+	// Comma separated field names, each prefixed with - to sort descending, such as missionType,-numPlayers.
+	// Throws if a name does not match a field.
+	void AddKeys(std::string_view keyList);
+
+	bool IsEmpty() const { return keys.empty(); }
+
+	bool IsBefore(const MissionRow& a, const MissionRow& b) const;
+
+private:
+	struct SortKey
+	{
+		MissionField field;
+		bool isDescending;
+	};
+
+	std::vector<SortKey> keys;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Outpost2DllExportedDefinitions.h"
+#include "ContentHash.h"
+#include <string>
+#include <optional>
+#include <cstdint>
+
+
+// Size and modification time used to detect whether a file changed since it was cached
+struct FileStamp
+{
+	std::uint64_t size;
+	std::int64_t modifiedTime;
+
+	bool operator==(const FileStamp& other) const
+	{
+		return size == other.size && modifiedTime == other.modifiedTime;
+	}
+};
+
+// Details parsed from a single mission DLL, ready to be written as a table row
+// Fields are filled in column order, stopping at the first one that fails to read
+struct MissionRow
+{
+	std::string path;
+	std::string filename;
+	std::uint32_t timeDateStamp = 0;
+	bool isMission = false;
+	std::string openError;
+	std::optional<AIModDesc32> aiModDesc;
+	std::optional<std::string> mapName;
+	std::optional<std::string> techtreeName;
+	std::optional<std::string> levelDesc;
+	std::string readError;
+
+	// Mission did not match the scan's filter. Strings may not have been read.
+	bool isFilteredOut = false;
+
+	// Only set when deduplicating. Digest of the whole file, and the path of the first DLL written with the same content.
+	std::optional<ContentDigest> contentDigest;
+	std::string duplicateOf;
+
+	// Only set when caching, or when the scan's rowScanned callback is set.
+	// Taken before the file is opened, so a change made while parsing is seen as a change later.
+	std::optional<FileStamp> fileStamp;
+};
@@ -0,0 +1,222 @@
+#include "MissionRowSorter.h"
+#include "ScanCache.h"
+#include "BinaryStream.h"
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <memory>
+#include <system_error>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+// Runs merged at once. More runs are first merged in groups into longer runs, bounding open files and read buffers.
+constexpr std::size_t maxMergeWidth = 64;
+
+std::size_t EstimateRowSize(const MissionRow& row);
+void WriteRunRow(std::ostream& stream, const MissionRow& row);
+MissionRow ReadRunRow(std::istream& stream);
+
+
+MissionRowSorter::MissionRowSorter(const MissionSortOrder& sortOrder, std::size_t memoryLimit) :
+	sortOrder(sortOrder),
+	memoryLimit(memoryLimit)
+{
+}
+
+MissionRowSorter::~MissionRowSorter()
+{
+	for (const auto& runFilename : runFilenames) {
+		std::error_code errorCode;
+		fs::remove(runFilename, errorCode);
+	}
+}
+
+void MissionRowSorter::Add(MissionRow row)
+{
+	rowsSize += EstimateRowSize(row);
+	rows.push_back(std::move(row));
+
+	if (memoryLimit != 0 && rowsSize > memoryLimit) {
+		SpillRun();
+	}
+}
+
+void MissionRowSorter::ForEachSorted(const std::function<void(MissionRow& row)>& rowSorted)
+{
+	if (runs.empty()) {
+		SortRows();
+		for (auto& row : rows) {
+			rowSorted(row);
+		}
+		rows.clear();
+		return;
+	}
+
+	if (!rows.empty()) {
+		SpillRun();
+	}
+
+	// Each pass replaces groups of consecutive runs with one merged run, so ties still favor earlier rows
+	while (runs.size() > maxMergeWidth) {
+		std::vector<Run> mergedRuns;
+		for (std::size_t firstRun = 0; firstRun < runs.size(); firstRun += maxMergeWidth) {
+			const auto runCount = std::min(maxMergeWidth, runs.size() - firstRun);
+			Run mergedRun{ CreateRunFilename(), 0 };
+			{
+				std::ofstream stream(mergedRun.filename, std::ios::binary | std::ios::trunc);
+				if (!stream) {
+					throw std::runtime_error("Unable to write sort run : " + mergedRun.filename);
+				}
+				stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+				MergeRuns(firstRun, runCount, [&stream, &mergedRun](MissionRow& row) {
+					WriteRunRow(stream, row);
+					++mergedRun.rowCount;
+				});
+			}
+			mergedRuns.push_back(std::move(mergedRun));
+		}
+
+		for (const auto& run : runs) {
+			std::error_code errorCode;
+			fs::remove(run.filename, errorCode);
+		}
+		runs = std::move(mergedRuns);
+	}
+
+	MergeRuns(0, runs.size(), rowSorted);
+}
+
+// Stable, so rows equal on every key stay in the order they were added
+void MissionRowSorter::SortRows()
+{
+	std::stable_sort(rows.begin(), rows.end(), [this](const MissionRow& a, const MissionRow& b) {
+		return sortOrder.IsBefore(a, b);
+	});
+}
+
+void MissionRowSorter::SpillRun()
+{
+	SortRows();
+
+	Run run{ CreateRunFilename(), rows.size() };
+	runs.push_back(run);
+
+	std::ofstream stream(run.filename, std::ios::binary | std::ios::trunc);
+	if (!stream) {
+		throw std::runtime_error("Unable to write sort run : " + run.filename);
+	}
+	stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+	for (const auto& row : rows) {
+		WriteRunRow(stream, row);
+	}
+
+	// Release the capacity as well, so memory held does not stay at the limit between runs
+	std::vector<MissionRow>().swap(rows);
+	rowsSize = 0;
+}
+
+// Repeatedly hands out the least front row of the runs. Ties go to the earliest run.
+void MissionRowSorter::MergeRuns(std::size_t firstRun, std::size_t runCount, const std::function<void(MissionRow& row)>& rowMerged)
+{
+	struct RunReader
+	{
+		std::ifstream stream;
+		std::uint64_t rowsLeft;
+		MissionRow row;
+	};
+
+	std::vector<std::unique_ptr<RunReader>> readers;
+	for (std::size_t i = firstRun; i < firstRun + runCount; ++i) {
+		auto reader = std::make_unique<RunReader>();
+		reader->stream.open(runs[i].filename, std::ios::binary);
+		if (!reader->stream) {
+			throw std::runtime_error("Unable to read sort run : " + runs[i].filename);
+		}
+		reader->stream.exceptions(std::ios::failbit | std::ios::badbit);
+		reader->rowsLeft = runs[i].rowCount;
+		readers.push_back(std::move(reader));
+	}
+
+	const auto isAfter = [this, &readers](std::size_t a, std::size_t b) {
+		if (sortOrder.IsBefore(readers[b]->row, readers[a]->row)) {
+			return true;
+		}
+		return !sortOrder.IsBefore(readers[a]->row, readers[b]->row) && a > b;
+	};
+	std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(isAfter)> frontRows(isAfter);
+
+	for (std::size_t i = 0; i < readers.size(); ++i) {
+		if (readers[i]->rowsLeft > 0) {
+			readers[i]->row = ReadRunRow(readers[i]->stream);
+			--readers[i]->rowsLeft;
+			frontRows.push(i);
+		}
+	}
+
+	while (!frontRows.empty()) {
+		const auto readerIndex = frontRows.top();
+		frontRows.pop();
+
+		auto& reader = *readers[readerIndex];
+		rowMerged(reader.row);
+
+		if (reader.rowsLeft > 0) {
+			reader.row = ReadRunRow(reader.stream);
+			--reader.rowsLeft;
+			frontRows.push(readerIndex);
+		}
+	}
+}
+
+std::string MissionRowSorter::CreateRunFilename()
+{
+	// A random prefix keeps concurrent scans sharing the temporary directory apart
+	if (runFilenamePrefix.empty()) {
+		std::random_device randomDevice;
+		const auto randomValue = (static_cast<std::uint64_t>(randomDevice()) << 32) | randomDevice();
+		runFilenamePrefix = (fs::temp_directory_path() / ("missionScanner-" + std::to_string(randomValue) + "-")).string();
+	}
+
+	runFilenames.push_back(runFilenamePrefix + std::to_string(runFilenames.size()) + ".run");
+	return runFilenames.back();
+}
+
+
+// Approximate heap and vector use, so the limit tracks long strings as well as row count
+std::size_t EstimateRowSize(const MissionRow& row)
+{
+	std::size_t size = sizeof(MissionRow) + row.path.capacity() + row.filename.capacity() + row.openError.capacity() +
+		row.readError.capacity() + row.duplicateOf.capacity();
+
+	for (const auto* value : { &row.mapName, &row.techtreeName, &row.levelDesc }) {
+		if (*value) {
+			size += (*value)->capacity();
+		}
+	}
+
+	return size;
+}
+
+void WriteRunRow(std::ostream& stream, const MissionRow& row)
+{
+	WriteCacheEntry(stream, row, FileStamp{ 0, 0 });
+	WriteString(stream, row.duplicateOf);
+}
+
+MissionRow ReadRunRow(std::istream& stream)
+{
+	FileStamp fileStamp;
+	auto row = ReadCacheEntry(stream, fileStamp);
+	row.duplicateOf = ReadString(stream);
+	return row;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MissionRow.h"
+#include "MissionQuery.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+
+// Sorts rows for --sort-by, keeping rows equal on every key in the order they were added.
+// Once held rows exceed the memory limit, they are sorted into a run file in the temporary directory,
+// and runs are merged as rows are handed out, so memory use does not grow with the number of rows.
+class MissionRowSorter
+{
+public:
+	// A memory limit of 0 holds every row in memory
+	MissionRowSorter(const MissionSortOrder& sortOrder, std::size_t memoryLimit);
+
+	// Removes any run files left, such as when a scan is cancelled
+	~MissionRowSorter();
+
+	MissionRowSorter(const MissionRowSorter&) = delete;
+	MissionRowSorter& operator=(const MissionRowSorter&) = delete;
+
+	void Add(MissionRow row);
+
+	// Hands out every row added, in sorted order. Call once, after the last row is added.
+	void ForEachSorted(const std::function<void(MissionRow& row)>& rowSorted);
+
+private:
+	struct Run
+	{
+		std::string filename;
+		std::uint64_t rowCount;
+	};
+
+	const MissionSortOrder& sortOrder;
+	std::size_t memoryLimit;
+	std::vector<MissionRow> rows;
+	std::size_t rowsSize = 0;
+
+	// In the order their rows were added, which breaks ties when merging
+	std::vector<Run> runs;
+
+	// Every run file created, including runs merged into longer ones, so all are removed
+	std::vector<std::string> runFilenames;
+	std::string runFilenamePrefix;
+
+	void SortRows();
+	void SpillRun();
+	void MergeRuns(std::size_t firstRun, std::size_t runCount, const std::function<void(MissionRow& row)>& rowMerged);
+	std::string CreateRunFilename();
+};
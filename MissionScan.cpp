@@ -0,0 +1,651 @@
+#include "MissionScan.h"
+#include "DllExportReader32.h"
+#include "MissionArchive.h"
+#include "ScanCache.h"
+#include "ScanStats.h"
+#include "PrefixReadQueue.h"
+#include "MissionRowSorter.h"
+#include <string_view>
+#include <stdexcept>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+// Rows parsed so far keyed by content digest, so DLLs with identical content are only parsed once.
+// Safe to use from multiple worker threads.
+class ParsedRowIndex
+{
+public:
+	// Returns the row parsed for an earlier DLL with the same content, waiting if it is still being parsed.
+	// Otherwise returns nullopt, and the caller must Publish the row it parses.
+	std::optional<MissionRow> FindOrClaim(const ContentDigest& contentDigest);
+	void Publish(const ContentDigest& contentDigest, const MissionRow& row);
+
+private:
+	std::mutex mutex;
+	std::condition_variable rowPublishedCondition;
+
+	// Entry is empty while the claiming DLL is parsed
+	std::unordered_map<ContentDigest, std::optional<MissionRow>, ContentDigestHasher> rows;
+};
+
+// String exported by a mission, along with the AIModDesc pointer it is read through
+struct MissionString
+{
+	std::optional<std::string> MissionRow::* member;
+	std::uint32_t AIModDesc32::* address;
+	std::string_view exportName;
+	MissionField field;
+};
+
+// Column order, which strings are read in unless a filter tests them
+const std::array<MissionString, 3> missionStrings{ {
+	{ &MissionRow::mapName, &AIModDesc32::mapName, "MapName", MissionField::MapName },
+	{ &MissionRow::techtreeName, &AIModDesc32::techtreeName, "TechtreeName", MissionField::TechtreeName },
+	{ &MissionRow::levelDesc, &AIModDesc32::levelDesc, "LevelDesc", MissionField::LevelDesc }
+} };
+
+// Path waiting for a worker, in the order the source found it
+struct PendingPath
+{
+	std::size_t index;
+	std::string path;
+
+	// Read ahead by a PrefixReadQueue. Empty when the worker reads the headers itself.
+	std::optional<std::string> headerPrefix;
+};
+
+MissionRow ScanRow(const PendingPath& pendingPath, ScanCache* scanCache, ParsedRowIndex* parsedRows, const MissionFilter& missionFilter, bool isFileStampNeeded, FileScanStats& fileStats);
+MissionRow ParseRow(const std::string& missionPath, const std::optional<std::string>& headerPrefix, ParsedRowIndex* parsedRows, const MissionFilter& missionFilter, FileScanStats& fileStats);
+bool IsWorthReadingAhead(std::string_view headerPrefix);
+bool IsMissionImageFormat(DllExportReader32::ImageFormat imageFormat);
+MissionRow CopyParsedRow(MissionRow parsedRow, const std::string& missionPath);
+std::string GetMissionFilename(const std::string& missionPath);
+void ReadRowDetails(DllExportReader32& dllReader, MissionRow& row, const MissionFilter& missionFilter);
+std::string ReadMissionString(DllExportReader32& dllReader, std::uint32_t address, std::string_view exportName);
+
+// Thrown through the source's path sink, so a cancelled scan stops discovering paths
+struct ScanCancelled { };
+
+// Rough memory for each path between the source and output, including its row once parsed.
+// A quarter of a memory limit goes to paths in flight, and half to rows held for sorting.
+constexpr std::size_t inFlightPathSize = 1024;
+
+
+void ScanMissions(std::vector<std::string> missionPaths, const ScanOptions& scanOptions,
+	const MissionRecordCallback& missionFound, const ScanErrorCallback& scanError)
+{
+	std::sort(missionPaths.begin(), missionPaths.end());
+
+	ScanMissions([&missionPaths](const MissionPathSink& addMissionPath) {
+		for (auto& missionPath : missionPaths) {
+			addMissionPath(std::move(missionPath));
+		}
+	}, scanOptions, missionFound, scanError);
+}
+
+void ScanMissions(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions,
+	const MissionRecordCallback& missionFound, const ScanErrorCallback& scanError)
+{
+	ScanMissionRows(missionPathSource, scanOptions, [&](MissionRow& row) {
+		if (!row.openError.empty()) {
+			if (scanError) {
+				scanError(row.path, row.openError);
+			}
+		}
+		else if (IsRowSelected(row)) {
+			missionFound(ToMissionRecord(std::move(row)));
+		}
+	});
+}
+
+MissionRecord ToMissionRecord(MissionRow row)
+{
+	MissionRecord missionRecord;
+	missionRecord.path = std::move(row.path);
+	missionRecord.name = std::move(row.filename);
+	missionRecord.timeDateStamp = row.timeDateStamp;
+
+	if (row.aiModDesc) {
+		missionRecord.description = MissionDescription{
+			static_cast<MissionTypes>(row.aiModDesc->missionType),
+			row.aiModDesc->numPlayers,
+			row.aiModDesc->maxTechLevel,
+			row.aiModDesc->boolUnitMission != 0,
+			row.aiModDesc->checksum
+		};
+	}
+
+	missionRecord.mapName = std::move(row.mapName);
+	missionRecord.techtreeName = std::move(row.techtreeName);
+	missionRecord.levelDesc = std::move(row.levelDesc);
+	missionRecord.readError = std::move(row.readError);
+	missionRecord.duplicateOf = std::move(row.duplicateOf);
+	return missionRecord;
+}
+
+bool IsRowSelected(const MissionRow& row)
+{
+	return row.openError.empty() && row.isMission && !row.isFilteredOut;
+}
+
+void ScanMissionRows(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions, const MissionRowCallback& rowReady)
+{
+	std::optional<ScanCache> scanCache;
+	if (!scanOptions.cacheFilename.empty()) {
+		scanCache.emplace(scanOptions.cacheFilename);
+	}
+
+	std::optional<ParsedRowIndex> parsedRows;
+	if (scanOptions.dedupe) {
+		parsedRows.emplace();
+	}
+
+	// Falls back to workers reading headers with blocking reads when io_uring is unavailable
+	std::optional<PrefixReadQueue> prefixReadQueue;
+	if (scanOptions.queueDepth > 0) {
+		try {
+			prefixReadQueue.emplace(scanOptions.queueDepth, DllExportReader32::headerProbeSize, IsWorthReadingAhead);
+		}
+		catch (const std::runtime_error&) {
+		}
+	}
+
+	// The source discovers paths on its own thread while workers parse DLLs in any order.
+	// With a prefix read queue, paths pass through a reader thread first, which keeps their header reads in flight together.
+	// Rows are handed out in the order paths were discovered, as soon as each is ready.
+	std::mutex scanMutex;
+	std::condition_variable pathFoundCondition;
+	std::condition_variable pathAddedCondition;
+	std::condition_variable rowReadyCondition;
+	std::deque<PendingPath> unreadPaths;
+	std::deque<PendingPath> pendingPaths;
+	std::map<std::size_t, MissionRow> readyRows;
+	std::size_t pathCount = 0;
+	std::size_t writtenCount = 0;
+	bool isSourceFinished = false;
+	bool arePendingPathsFinished = false;
+	bool isCancelled = false;
+	std::exception_ptr sourceException;
+	std::exception_ptr readerException;
+
+	// With a memory limit, the source waits for output to catch up rather than queueing every path it finds
+	std::condition_variable rowWrittenCondition;
+	const std::size_t maxPathsInFlight = scanOptions.memoryLimit == 0 ? 0 :
+		std::max(scanOptions.memoryLimit / 4 / inFlightPathSize, 2 * std::max<std::size_t>(scanOptions.jobCount, 1) + scanOptions.queueDepth);
+
+	std::thread sourceThread([&]() {
+		try {
+			missionPathSource([&](std::string missionPath) {
+				{
+					std::unique_lock<std::mutex> lock(scanMutex);
+					if (maxPathsInFlight != 0) {
+						rowWrittenCondition.wait(lock, [&]() { return pathCount - writtenCount < maxPathsInFlight || isCancelled; });
+					}
+					if (isCancelled) {
+						throw ScanCancelled();
+					}
+					auto& paths = prefixReadQueue ? unreadPaths : pendingPaths;
+					paths.push_back(PendingPath{ pathCount++, std::move(missionPath), std::nullopt });
+				}
+				(prefixReadQueue ? pathFoundCondition : pathAddedCondition).notify_one();
+			});
+		}
+		catch (const ScanCancelled&) {
+		}
+		catch (...) {
+			sourceException = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(scanMutex);
+			isSourceFinished = true;
+			arePendingPathsFinished = !prefixReadQueue;
+		}
+		pathFoundCondition.notify_all();
+		pathAddedCondition.notify_all();
+		rowReadyCondition.notify_all();
+	});
+
+	// Submits header reads while slots are free, and passes paths on to workers as their reads complete.
+	// Waits on the queue while reads are in flight, and otherwise on the source.
+	auto readPrefixes = [&]() {
+		std::unordered_map<std::uint64_t, PendingPath> readingPaths;
+
+		try {
+			while (true) {
+				std::vector<PendingPath> readPaths;
+				std::vector<PendingPath> submittedPaths;
+				{
+					std::unique_lock<std::mutex> lock(scanMutex);
+					if (prefixReadQueue->IsIdle()) {
+						pathFoundCondition.wait(lock, [&]() { return !unreadPaths.empty() || isSourceFinished || isCancelled; });
+					}
+					if (isCancelled || (isSourceFinished && unreadPaths.empty() && prefixReadQueue->IsIdle())) {
+						break;
+					}
+					while (!unreadPaths.empty() && submittedPaths.size() < prefixReadQueue->FreeSlotCount()) {
+						submittedPaths.push_back(std::move(unreadPaths.front()));
+						unreadPaths.pop_front();
+					}
+				}
+
+				// Archived DLLs are read from the archive by the worker
+				for (auto& pendingPath : submittedPaths) {
+					if (SplitArchivedPath(pendingPath.path)) {
+						readPaths.push_back(std::move(pendingPath));
+						continue;
+					}
+					prefixReadQueue->Submit(pendingPath.index, pendingPath.path);
+					readingPaths.emplace(pendingPath.index, std::move(pendingPath));
+				}
+
+				if (!prefixReadQueue->IsIdle()) {
+					for (auto& completedRead : prefixReadQueue->WaitForCompletions()) {
+						auto readingPath = readingPaths.find(completedRead.tag);
+						readingPath->second.headerPrefix = std::move(completedRead.prefix);
+						readPaths.push_back(std::move(readingPath->second));
+						readingPaths.erase(readingPath);
+					}
+				}
+
+				if (!readPaths.empty()) {
+					{
+						std::lock_guard<std::mutex> lock(scanMutex);
+						std::move(readPaths.begin(), readPaths.end(), std::back_inserter(pendingPaths));
+					}
+					pathAddedCondition.notify_all();
+				}
+			}
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(scanMutex);
+			readerException = std::current_exception();
+			isCancelled = true;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(scanMutex);
+			arePendingPathsFinished = true;
+		}
+		pathAddedCondition.notify_all();
+		rowReadyCondition.notify_all();
+		rowWrittenCondition.notify_all();
+	};
+	std::thread readerThread;
+	if (prefixReadQueue) {
+		readerThread = std::thread(readPrefixes);
+	}
+
+	auto parseRows = [&]() {
+		while (true) {
+			PendingPath pendingPath;
+			{
+				std::unique_lock<std::mutex> lock(scanMutex);
+				pathAddedCondition.wait(lock, [&]() { return !pendingPaths.empty() || arePendingPathsFinished || isCancelled; });
+				if (pendingPaths.empty() || isCancelled) {
+					return;
+				}
+				pendingPath = std::move(pendingPaths.front());
+				pendingPaths.pop_front();
+			}
+
+			FileScanStats fileStats;
+			const auto scanStartTime = ScanStats::Clock::now();
+			auto row = ScanRow(pendingPath, scanCache ? &*scanCache : nullptr, parsedRows ? &*parsedRows : nullptr, scanOptions.missionFilter, static_cast<bool>(scanOptions.rowScanned), fileStats);
+
+			// Cached and fully parsed rows are matched here, as only parsing stops early for rows the filter rejects
+			if (row.isMission && !row.isFilteredOut) {
+				row.isFilteredOut = !scanOptions.missionFilter.Matches(row);
+			}
+
+			if (scanOptions.scanStats) {
+				fileStats.latency = ScanStats::Clock::now() - scanStartTime;
+				scanOptions.scanStats->AddFile(row, fileStats);
+			}
+			{
+				std::lock_guard<std::mutex> lock(scanMutex);
+				readyRows.emplace(pendingPath.index, std::move(row));
+			}
+			rowReadyCondition.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (std::size_t i = 0; i < std::max<std::size_t>(scanOptions.jobCount, 1); ++i) {
+		workers.emplace_back(parseRows);
+	}
+
+	// Duplicates refer to the first DLL in output order, regardless of which worker parsed it
+	std::unordered_map<ContentDigest, std::string, ContentDigestHasher> firstPathsByContent;
+
+	// Selected rows held until the scan finishes when sorting
+	MissionRowSorter rowSorter(scanOptions.sortOrder, scanOptions.memoryLimit / 2);
+
+	// A callback that throws cancels the scan. Workers and the source are stopped before the exception is rethrown.
+	std::exception_ptr rowReadyException;
+	try {
+		for (std::size_t i = 0; ; ++i)
+		{
+			MissionRow row;
+			{
+				std::unique_lock<std::mutex> lock(scanMutex);
+				rowReadyCondition.wait(lock, [&]() { return readyRows.count(i) != 0 || (isSourceFinished && i >= pathCount) || readerException; });
+
+				const auto readyRow = readyRows.find(i);
+				if (readyRow == readyRows.end()) {
+					break;
+				}
+				row = std::move(readyRow->second);
+				readyRows.erase(readyRow);
+				writtenCount = i + 1;
+			}
+			if (maxPathsInFlight != 0) {
+				rowWrittenCondition.notify_one();
+			}
+
+			const auto writeStartTime = ScanStats::Clock::now();
+
+			if (scanOptions.rowScanned) {
+				scanOptions.rowScanned(row);
+			}
+
+			if (IsRowSelected(row) && row.contentDigest) {
+				const auto firstPath = firstPathsByContent.emplace(*row.contentDigest, row.path).first;
+				if (firstPath->second != row.path) {
+					row.duplicateOf = firstPath->second;
+				}
+			}
+
+			if (IsRowSelected(row) && !scanOptions.sortOrder.IsEmpty()) {
+				rowSorter.Add(std::move(row));
+			}
+			else {
+				rowReady(row);
+			}
+
+			if (scanOptions.scanStats) {
+				scanOptions.scanStats->AddWriteOutputTime(ScanStats::Clock::now() - writeStartTime);
+			}
+		}
+
+		// Rows equal on every key stay in the order they were found
+		const auto writeStartTime = ScanStats::Clock::now();
+		rowSorter.ForEachSorted(rowReady);
+		if (scanOptions.scanStats) {
+			scanOptions.scanStats->AddWriteOutputTime(ScanStats::Clock::now() - writeStartTime);
+		}
+	}
+	catch (...) {
+		rowReadyException = std::current_exception();
+		{
+			std::lock_guard<std::mutex> lock(scanMutex);
+			isCancelled = true;
+		}
+		pathFoundCondition.notify_all();
+		pathAddedCondition.notify_all();
+		rowWrittenCondition.notify_all();
+	}
+
+	sourceThread.join();
+	if (readerThread.joinable()) {
+		readerThread.join();
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Rows parsed before an error are still saved, but a failed save must not hide the error that stopped the scan
+	if (scanCache) {
+		const bool isScanComplete = !rowReadyException && !readerException && !sourceException;
+		try {
+			scanCache->Save(isScanComplete);
+		}
+		catch (const std::exception&) {
+			if (isScanComplete) {
+				throw;
+			}
+		}
+	}
+
+	if (rowReadyException) {
+		std::rethrow_exception(rowReadyException);
+	}
+	if (readerException) {
+		std::rethrow_exception(readerException);
+	}
+	if (sourceException) {
+		std::rethrow_exception(sourceException);
+	}
+}
+
+// Reuses the cached row when the file is unchanged since it was last parsed.
+// When deduplicating, cached rows without a content digest are parsed again.
+// Rows the filter rejected before all details were read are not cached.
+// Neither are rows with open or read errors, which may be transient, such as a permission change that only updates ctime.
+// Cache hits discard any header prefix read ahead.
+MissionRow ScanRow(const PendingPath& pendingPath, ScanCache* scanCache, ParsedRowIndex* parsedRows, const MissionFilter& missionFilter, bool isFileStampNeeded, FileScanStats& fileStats)
+{
+	const auto& missionPath = pendingPath.path;
+	if (scanCache == nullptr && !isFileStampNeeded) {
+		return ParseRow(missionPath, pendingPath.headerPrefix, parsedRows, missionFilter, fileStats);
+	}
+
+	const auto fileStamp = GetFileStamp(missionPath);
+	if (fileStamp && scanCache) {
+		auto cachedRow = scanCache->Find(missionPath, *fileStamp);
+		if (cachedRow && (parsedRows == nullptr || cachedRow->contentDigest || !cachedRow->isMission)) {
+			fileStats.isCacheHit = true;
+			cachedRow->fileStamp = fileStamp;
+			return std::move(*cachedRow);
+		}
+	}
+
+	auto row = ParseRow(missionPath, pendingPath.headerPrefix, parsedRows, missionFilter, fileStats);
+	row.fileStamp = fileStamp;
+	if (fileStamp && scanCache && !row.isFilteredOut && row.openError.empty() && row.readError.empty()) {
+		scanCache->Store(row, *fileStamp);
+	}
+	return row;
+}
+
+MissionRow ScanMissionRow(const std::string& missionPath)
+{
+	FileScanStats fileStats;
+	return ParseRow(missionPath, std::nullopt, nullptr, MissionFilter(), fileStats);
+}
+
+// Headers are read from the path unless a prefix was read ahead
+MissionRow ParseRow(const std::string& missionPath, const std::optional<std::string>& headerPrefix, ParsedRowIndex* parsedRows, const MissionFilter& missionFilter, FileScanStats& fileStats)
+{
+	// Each worker thread reuses one reader, so buffers are not reallocated for every DLL
+	thread_local DllExportReader32 dllExportedVariables;
+
+	MissionRow row;
+	row.path = missionPath;
+	bool isParseClaimed = false;
+
+	try {
+		const auto openStartTime = ScanStats::Clock::now();
+
+		// Most DLLs outside of mission folders are rejected here, without reading the whole file.
+		// Outpost 2 only loads 32 bit DLLs, so other image formats, such as 64 bit tools, are rejected as well.
+		const auto headerProbe = headerPrefix ? ProbeMissionHeaders(*headerPrefix, dllExportedVariables) : ProbeMissionDll(missionPath, dllExportedVariables);
+		fileStats.imageReads = headerProbe.readCounters;
+		if (!headerProbe.hasExportTable || !IsMissionImageFormat(headerProbe.imageFormat.value_or(DllExportReader32::ImageFormat::Pe32))) {
+			row.timeDateStamp = headerProbe.timeDateStamp;
+			fileStats.isRejectedByProbe = true;
+			fileStats.openTime = ScanStats::Clock::now() - openStartTime;
+			return row;
+		}
+
+		OpenMissionDll(missionPath, dllExportedVariables);
+		const auto readStartTime = ScanStats::Clock::now();
+		fileStats.openTime = readStartTime - openStartTime;
+
+		row.timeDateStamp = dllExportedVariables.TimeDateStamp();
+
+		if (parsedRows) {
+			row.contentDigest = dllExportedVariables.DigestImage();
+			auto parsedRow = parsedRows->FindOrClaim(*row.contentDigest);
+			if (parsedRow) {
+				row = CopyParsedRow(std::move(*parsedRow), missionPath);
+				fileStats.isDeduplicated = true;
+			}
+			isParseClaimed = !parsedRow;
+		}
+
+		// Archived DLLs are not probed, so their format is only known once opened
+		if (!fileStats.isDeduplicated && IsMissionImageFormat(dllExportedVariables.Format()) && dllExportedVariables.DoesExportExist("LevelDesc")) {
+			row.isMission = true;
+			row.filename = GetMissionFilename(missionPath);
+
+			// Copies share this row's filter decision, so it must not depend on this DLL's path or name.
+			// The worker matches every row against the full filter once parsed.
+			const bool isFilterOnPath = missionFilter.UsesField(MissionField::Path) || missionFilter.UsesField(MissionField::Name);
+			ReadRowDetails(dllExportedVariables, row, isParseClaimed && isFilterOnPath ? MissionFilter() : missionFilter);
+		}
+
+		fileStats.readExportsTime = ScanStats::Clock::now() - readStartTime;
+		fileStats.imageReads += dllExportedVariables.ReadCounters();
+	}
+	catch (const std::exception& e) {
+		row.openError = e.what();
+	}
+
+	// Copies waiting on this DLL's content receive the row, including any error
+	if (isParseClaimed) {
+		parsedRows->Publish(*row.contentDigest, row);
+	}
+
+	dllExportedVariables.Close();
+	return row;
+}
+
+// Only DLLs the header probe passes on to be opened are read ahead. Others are left for the worker to report or reject.
+// Runs on the prefix reader's thread.
+bool IsWorthReadingAhead(std::string_view headerPrefix)
+{
+	thread_local DllExportReader32 dllReader;
+
+	try {
+		const auto headerProbe = ProbeMissionHeaders(headerPrefix, dllReader);
+		return headerProbe.hasExportTable && IsMissionImageFormat(headerProbe.imageFormat.value_or(DllExportReader32::ImageFormat::Pe32));
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+}
+
+bool IsMissionImageFormat(DllExportReader32::ImageFormat imageFormat)
+{
+	return imageFormat == DllExportReader32::ImageFormat::Pe32;
+}
+
+// Details and errors come from the DLL that was parsed, while the path and name are the copy's own
+MissionRow CopyParsedRow(MissionRow parsedRow, const std::string& missionPath)
+{
+	parsedRow.path = missionPath;
+	if (parsedRow.isMission) {
+		parsedRow.filename = GetMissionFilename(missionPath);
+	}
+	return parsedRow;
+}
+
+std::string GetMissionFilename(const std::string& missionPath)
+{
+	return fs::path(missionPath).filename().replace_extension().string();
+}
+
+std::optional<MissionRow> ParsedRowIndex::FindOrClaim(const ContentDigest& contentDigest)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	const auto [entry, isClaimed] = rows.try_emplace(contentDigest);
+	if (isClaimed) {
+		return std::nullopt;
+	}
+
+	// References to elements remain valid when other claims rehash the map
+	const auto& parsedRow = entry->second;
+	rowPublishedCondition.wait(lock, [&parsedRow]() { return parsedRow.has_value(); });
+	return parsedRow;
+}
+
+void ParsedRowIndex::Publish(const ContentDigest& contentDigest, const MissionRow& row)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		rows[contentDigest] = row;
+	}
+	rowPublishedCondition.notify_all();
+}
+
+// Rows the filter rejects stop reading as soon as possible, marked as filtered out.
+// Strings tested by the filter are read first, so the remaining strings are only read for rows that match.
+void ReadRowDetails(DllExportReader32& dllReader, MissionRow& row, const MissionFilter& missionFilter)
+{
+	try
+	{
+		const auto descBlock = dllReader.ReadExport<AIModDesc32>("DescBlock");
+		row.aiModDesc = descBlock;
+
+		if (!missionFilter.IsEmpty()) {
+			if (!missionFilter.MatchesBeforeStrings(row)) {
+				row.isFilteredOut = true;
+				return;
+			}
+
+			for (const auto& missionString : missionStrings) {
+				if (missionFilter.UsesField(missionString.field)) {
+					row.*missionString.member = ReadMissionString(dllReader, descBlock.*missionString.address, missionString.exportName);
+				}
+			}
+
+			if (!missionFilter.Matches(row)) {
+				row.isFilteredOut = true;
+				return;
+			}
+		}
+
+		for (const auto& missionString : missionStrings) {
+			if (!(row.*missionString.member)) {
+				row.*missionString.member = ReadMissionString(dllReader, descBlock.*missionString.address, missionString.exportName);
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		row.readError = e.what();
+	}
+}
+
+// Strings are read through the AIModDesc pointer when it is set.
+// Some missions do not store LevelDesc, MapName, and TechTreeName within AIModDesc, so fall back to the named export.
+std::string ReadMissionString(DllExportReader32& dllReader, std::uint32_t address, std::string_view exportName)
+{
+	const auto text = dllReader.ReadStringAtVirtualAddress(address);
+	if (text) {
+		return std::string(*text);
+	}
+
+	return std::string(dllReader.ReadExportString(exportName));
+}
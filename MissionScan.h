@@ -0,0 +1,81 @@
+#pragma once
+
+#include "MissionTable.h"
+#include "MissionRow.h"
+#include "Outpost2DllExportedDefinitions.h"
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <cstdint>
+
+
+// In process scanning, for hosts such as a lobby server that would otherwise run MissionScanner and parse its output.
+// Link with libmissionscanner.a. The console executable writes its tables through the same functions.
+
+// Level details from a mission's DescBlock (AIModDesc)
+struct MissionDescription
+{
+	// Mission type, or the mission number for campaign missions
+	MissionTypes missionType;
+	int numPlayers;
+	int maxTechLevel;
+	bool isUnitMission;
+	int checksum;
+};
+
+// A single mission DLL, as handed to ScanMissions callbacks
+struct MissionRecord
+{
+	std::string path;
+
+	// DLL filename without its extension
+	std::string name;
+
+	// Link time recorded in the COFF header
+	std::uint32_t timeDateStamp = 0;
+
+	// Empty if DescBlock could not be read
+	std::optional<MissionDescription> description;
+
+	// Empty if the string could not be read
+	std::optional<std::string> mapName;
+	std::optional<std::string> techtreeName;
+	std::optional<std::string> levelDesc;
+
+	// Set when some details could not be read
+	std::string readError;
+
+	// Only set when deduplicating. Path of the first DLL with identical content.
+	std::string duplicateOf;
+};
+
+using MissionRecordCallback = std::function<void(const MissionRecord& missionRecord)>;
+
+// Receives the path and error message of each DLL that could not be opened
+using ScanErrorCallback = std::function<void(const std::string& path, const std::string& message)>;
+
+// Parses DLLs on scanOptions.jobCount worker threads, calling back on the calling thread.
+// Missions are handed out in path order, or in scanOptions.sortOrder once the scan finishes.
+// DLLs that are not missions, or do not match scanOptions.missionFilter, are skipped.
+// Output options, such as the format and legend, are ignored. Nothing is written to std::cout or std::cerr.
+// An exception thrown by a callback stops the scan, and is rethrown once workers finish their current DLL.
+void ScanMissions(std::vector<std::string> missionPaths, const ScanOptions& scanOptions,
+	const MissionRecordCallback& missionFound, const ScanErrorCallback& scanError = nullptr);
+void ScanMissions(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions,
+	const MissionRecordCallback& missionFound, const ScanErrorCallback& scanError = nullptr);
+
+MissionRecord ToMissionRecord(MissionRow row);
+
+
+// Lower level scan used by ScanMissions and WriteTable.
+// Every row is handed out on the calling thread, in the order the source supplies paths,
+// except that missions selected for output are held until the scan finishes when sorting.
+using MissionRowCallback = std::function<void(MissionRow& row)>;
+void ScanMissionRows(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions, const MissionRowCallback& rowReady);
+
+// True for missions that match the filter, which table output writes
+bool IsRowSelected(const MissionRow& row);
+
+// Parses a single DLL, as ScanMissionRows does for each path
+MissionRow ScanMissionRow(const std::string& missionPath);
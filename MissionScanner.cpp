@@ -1,8 +1,27 @@
 #include "MissionTable.h"
+#include "ExportTable.h"
+#include "MissionArchive.h"
+#include "ScanStats.h"
+#include "MissionWatcher.h"
+#include "MissionServer.h"
 #include "OP2Utility.h"
 #include <iostream>
+#include <fstream>
 #include <stdexcept>
 #include <cstddef>
+#include <algorithm>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <limits>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
 
 
 const std::string version("1.0.0");
@@ -10,10 +29,20 @@ const std::string version("1.0.0");
 void OutputHelp();
 std::vector<std::string> GatherArguments(int argc, char** argv);
 bool FindAndRemoveSwitch(std::vector<std::string>& arguments, const std::vector<std::string_view>& switchOptions);
+std::optional<std::string> FindAndRemoveSwitchValue(std::vector<std::string>& arguments, const std::vector<std::string_view>& switchOptions);
+std::size_t ParseJobCount(std::vector<std::string>& arguments);
+std::size_t ParseQueueDepth(std::vector<std::string>& arguments);
+std::size_t ParseMemoryLimit(std::vector<std::string>& arguments);
+std::string ParseCacheFilename(std::vector<std::string>& arguments);
+void WriteScanStats(const ScanStats& scanStats, const std::optional<std::string>& statsFilename);
+std::vector<std::string> FindWatchDirectories(const std::vector<std::string>& arguments);
 std::vector<std::string> FindMissionPaths(const std::vector<std::string>& arguments);
+void FindMissionPathsSorted(std::vector<std::string> arguments, bool recursive, const MissionPathSink& addMissionPath);
+void FindDirectoryMissionPathsSorted(const fs::path& directory, bool recursive, const MissionPathSink& addMissionPath);
+std::string GetPathSortKey(const fs::path& path, bool isDirectory);
 
 
-// Does not recursively search subdirectories
+// Only searches subdirectories when the recursive switch is present
 int main(int argc, char** argv)
 {
 	try {
@@ -27,16 +56,163 @@ int main(int argc, char** argv)
 			return 0;
 		}
 
+		ScanOptions scanOptions;
+
 		// Legend Switch. Write legend if switch is not present
-		bool writeLegend = !FindAndRemoveSwitch(arguments, { "-L", "--L", "--Legend" });
+		scanOptions.writeLegend = !FindAndRemoveSwitch(arguments, { "-L", "--L", "--Legend" });
+
+		// Recursive Switch. Search subdirectories, parsing DLLs while the search continues
+		const bool recursive = FindAndRemoveSwitch(arguments, { "-R", "--recursive", "--Recursive" });
+
+		// Jobs Switch. Number of DLLs parsed concurrently
+		scanOptions.jobCount = ParseJobCount(arguments);
+
+		// Queue Depth Switch. Keep header reads of this many DLLs in flight with io_uring
+		scanOptions.queueDepth = ParseQueueDepth(arguments);
+
+		// Max Memory Switch. Stream paths and spill sorted rows to temporary files, rather than holding every path and row
+		scanOptions.memoryLimit = ParseMemoryLimit(arguments);
+
+		// Cache Switches. Reuse rows parsed by a previous run for unchanged DLLs
+		scanOptions.cacheFilename = ParseCacheFilename(arguments);
+
+		// Dedupe Switch. Parse identical DLLs once, and report later copies as duplicates of the first
+		scanOptions.dedupe = FindAndRemoveSwitch(arguments, { "-D", "--dedupe", "--Dedupe" });
+
+		// Format Switch. Write the table as text, csv, jsonl or bin
+		const auto outputFormat = FindAndRemoveSwitchValue(arguments, { "-F", "--format", "--Format" });
+		if (outputFormat) {
+			scanOptions.outputFormat = ParseOutputFormat(*outputFormat);
+		}
+
+		// Stats Switches. Summarize timings and reads to stderr, or to a JSON file
+		const auto statsFilename = FindAndRemoveSwitchValue(arguments, { "--stats-file", "--StatsFile" });
+		const bool writeStats = FindAndRemoveSwitch(arguments, { "-S", "--stats", "--Stats" }) || statsFilename;
+		std::optional<ScanStats> scanStats;
+		if (writeStats) {
+			scanOptions.scanStats = &scanStats.emplace();
+		}
+
+		// Where Switches. Only write missions matching every condition
+		while (const auto condition = FindAndRemoveSwitchValue(arguments, { "--where", "--Where" })) {
+			scanOptions.missionFilter.AddCondition(*condition);
+		}
+
+		// Sort Switches. Order rows by the given fields instead of by path
+		while (const auto sortKeys = FindAndRemoveSwitchValue(arguments, { "--sort-by", "--SortBy" })) {
+			scanOptions.sortOrder.AddKeys(*sortKeys);
+		}
+		const bool isQuery = !scanOptions.missionFilter.IsEmpty() || !scanOptions.sortOrder.IsEmpty();
+
+		// Exports Switch. List every export of each DLL instead of the mission table
+		const bool listExports = FindAndRemoveSwitch(arguments, { "-E", "--exports", "--Exports" });
+		if (listExports && isQuery) {
+			throw std::runtime_error("Where and sort by only apply to the mission table, not to listing exports");
+		}
 
-		const auto missionPaths = FindMissionPaths(arguments);
-		if (missionPaths.size() > 0) {
-			if (writeLegend) {
-				WriteLegend();
+		// Serve Switch. Keep the catalog in memory, answering queries over a Unix domain socket instead of writing the table
+		const auto serveSocketPath = FindAndRemoveSwitchValue(arguments, { "--serve", "--Serve" });
+		if (serveSocketPath) {
+			if (listExports) {
+				throw std::runtime_error("Serve can not be combined with listing exports");
 			}
+			if (writeStats) {
+				throw std::runtime_error("Serve can not be combined with stats");
+			}
+		}
+
+		// Watch Switch. After the table, write changes to missions in the given directories as JSON lines
+		std::optional<MissionWatcher> missionWatcher;
+		if (FindAndRemoveSwitch(arguments, { "-W", "--watch", "--Watch" })) {
+			if (!outputFormat) {
+				scanOptions.outputFormat = OutputFormat::JsonLines;
+			}
+			if (scanOptions.outputFormat == OutputFormat::Binary) {
+				throw std::runtime_error("Watch events can not follow binary output");
+			}
+			if (listExports) {
+				throw std::runtime_error("Watch can not be combined with listing exports");
+			}
+			if (isQuery) {
+				throw std::runtime_error("Watch can not be combined with where or sort by");
+			}
+			if (serveSocketPath) {
+				throw std::runtime_error("Watch can not be combined with serve");
+			}
+
+			// Watches start before the table is written, so changes made during the initial scan are not missed
+			missionWatcher.emplace(FindWatchDirectories(arguments), recursive);
+			scanOptions.rowScanned = [&missionWatcher](const MissionRow& row) {
+				missionWatcher->AddScannedRow(row);
+			};
+		}
+
+		if (serveSocketPath) {
+			// Paths are found again for each rescan, so added and removed DLLs are picked up
+			MissionServer missionServer(*serveSocketPath, [&arguments, recursive](const MissionPathSink& addMissionPath) {
+				if (recursive) {
+					FindMissionPathsSorted(arguments, true, addMissionPath);
+					return;
+				}
 
-			WriteTable(missionPaths);
+				auto missionPaths = FindMissionPaths(arguments);
+				std::sort(missionPaths.begin(), missionPaths.end());
+				for (auto& missionPath : missionPaths) {
+					addMissionPath(std::move(missionPath));
+				}
+			}, scanOptions);
+			missionServer.Run();
+		}
+		else if (recursive || scanOptions.memoryLimit != 0) {
+			// Report invalid arguments before any output is written
+			for (const auto& argument : arguments) {
+				if (!XFile::IsDirectory(argument) && !XFile::IsFile(argument)) {
+					throw std::runtime_error("Invalid file or directory : " + argument);
+				}
+			}
+
+			// Time handing paths on, which includes waiting for the scan to catch up, is not counted as finding paths
+			const auto missionPathSource = [&arguments, recursive, &scanStats](const MissionPathSink& addMissionPath) {
+				const auto findStartTime = ScanStats::Clock::now();
+				ScanStats::Clock::duration sinkTime{};
+				FindMissionPathsSorted(arguments, recursive, [&](std::string missionPath) {
+					const auto sinkStartTime = ScanStats::Clock::now();
+					addMissionPath(std::move(missionPath));
+					sinkTime += ScanStats::Clock::now() - sinkStartTime;
+				});
+				if (scanStats) {
+					scanStats->AddFindPathsTime(ScanStats::Clock::now() - findStartTime - sinkTime);
+				}
+			};
+
+			if (listExports) {
+				WriteExportTable(missionPathSource, scanOptions);
+			}
+			else {
+				WriteTable(missionPathSource, scanOptions);
+			}
+		}
+		else {
+			const auto findStartTime = ScanStats::Clock::now();
+			auto missionPaths = FindMissionPaths(arguments);
+			if (scanStats) {
+				scanStats->AddFindPathsTime(ScanStats::Clock::now() - findStartTime);
+			}
+
+			if (listExports) {
+				WriteExportTable(std::move(missionPaths), scanOptions);
+			}
+			else {
+				WriteTable(std::move(missionPaths), scanOptions);
+			}
+		}
+
+		if (scanStats) {
+			WriteScanStats(*scanStats, statsFilename);
+		}
+
+		if (missionWatcher) {
+			missionWatcher->Run();
 		}
 	}
 	catch (const std::exception& e) {
@@ -76,6 +252,140 @@ bool FindAndRemoveSwitch(std::vector<std::string>& arguments, const std::vector<
 	return false;
 }
 
+// Returns the value following a switch after removing both from argument list
+std::optional<std::string> FindAndRemoveSwitchValue(std::vector<std::string>& arguments, const std::vector<std::string_view>& switchOptions)
+{
+	for (std::size_t i = 0; i < arguments.size(); ++i) {
+		for (const auto& switchOption : switchOptions) {
+			if (arguments[i] == switchOption) {
+				if (i + 1 >= arguments.size()) {
+					throw std::runtime_error("Missing value for switch : " + arguments[i]);
+				}
+
+				auto value = arguments[i + 1];
+				arguments.erase(arguments.begin() + i, arguments.begin() + i + 2);
+				return value;
+			}
+		}
+	}
+
+	return std::nullopt;
+}
+
+// Defaults to one job per hardware thread when switch is not present
+std::size_t ParseJobCount(std::vector<std::string>& arguments)
+{
+	const auto jobCountString = FindAndRemoveSwitchValue(arguments, { "-J", "--jobs", "--Jobs" });
+	if (!jobCountString) {
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	std::size_t charsProcessed = 0;
+	unsigned long jobCount = 0;
+	try {
+		jobCount = std::stoul(*jobCountString, &charsProcessed);
+	}
+	catch (const std::exception&) {
+	}
+
+	if (jobCount == 0 || charsProcessed != jobCountString->size()) {
+		throw std::runtime_error("Invalid job count : " + *jobCountString);
+	}
+
+	return jobCount;
+}
+
+// Zero when switch is not present, leaving each worker to read headers itself
+std::size_t ParseQueueDepth(std::vector<std::string>& arguments)
+{
+	const auto queueDepthString = FindAndRemoveSwitchValue(arguments, { "--queue-depth", "--QueueDepth" });
+	if (!queueDepthString) {
+		return 0;
+	}
+
+	std::size_t charsProcessed = 0;
+	unsigned long queueDepth = 0;
+	try {
+		queueDepth = std::stoul(*queueDepthString, &charsProcessed);
+	}
+	catch (const std::exception&) {
+	}
+
+	// io_uring rings hold at most 32768 entries, two per queued read
+	if (queueDepth == 0 || queueDepth > 16384 || charsProcessed != queueDepthString->size()) {
+		throw std::runtime_error("Invalid queue depth : " + *queueDepthString);
+	}
+
+	return queueDepth;
+}
+
+// Megabytes from the switch, in bytes. Zero when switch is not present, for no limit.
+std::size_t ParseMemoryLimit(std::vector<std::string>& arguments)
+{
+	const auto memoryLimitString = FindAndRemoveSwitchValue(arguments, { "--max-memory", "--MaxMemory" });
+	if (!memoryLimitString) {
+		return 0;
+	}
+
+	std::size_t charsProcessed = 0;
+	unsigned long megabytes = 0;
+	try {
+		megabytes = std::stoul(*memoryLimitString, &charsProcessed);
+	}
+	catch (const std::exception&) {
+	}
+
+	if (megabytes == 0 || megabytes > std::numeric_limits<std::size_t>::max() / (1024 * 1024) || charsProcessed != memoryLimitString->size()) {
+		throw std::runtime_error("Invalid memory limit : " + *memoryLimitString);
+	}
+
+	return static_cast<std::size_t>(megabytes) * 1024 * 1024;
+}
+
+// Returns an empty filename when caching is not requested, or is overridden by the no cache switch
+std::string ParseCacheFilename(std::vector<std::string>& arguments)
+{
+	const auto cacheFilename = FindAndRemoveSwitchValue(arguments, { "-C", "--cache", "--Cache" });
+	const bool noCache = FindAndRemoveSwitch(arguments, { "--no-cache", "--NoCache" });
+
+	if (!cacheFilename || noCache) {
+		return std::string();
+	}
+
+	return *cacheFilename;
+}
+
+void WriteScanStats(const ScanStats& scanStats, const std::optional<std::string>& statsFilename)
+{
+	if (!statsFilename) {
+		scanStats.WriteSummary(std::cerr);
+		return;
+	}
+
+	std::ofstream statsFile(*statsFilename);
+	scanStats.WriteJson(statsFile);
+	if (!statsFile) {
+		throw std::runtime_error("Unable to write stats file : " + *statsFilename);
+	}
+}
+
+// Files and archives are included in the table, but are not watched
+std::vector<std::string> FindWatchDirectories(const std::vector<std::string>& arguments)
+{
+	std::vector<std::string> directories;
+	for (const auto& argument : arguments) {
+		if (XFile::IsDirectory(argument)) {
+			directories.push_back(argument);
+		}
+	}
+
+	if (directories.empty()) {
+		throw std::runtime_error("Watch requires at least one directory");
+	}
+
+	return directories;
+}
+
 std::vector<std::string> FindMissionPaths(const std::vector<std::string>& arguments)
 {
 	std::vector<std::string> missionPaths;
@@ -91,6 +401,10 @@ std::vector<std::string> FindMissionPaths(const std::vector<std::string>& argume
 
 			missionPaths.insert(missionPaths.end(), directoryFilenames.begin(), directoryFilenames.end());
 		}
+		else if (IsArchiveFile(argument)) {
+			const auto archivedMissionPaths = FindArchivedMissionPaths(argument);
+			missionPaths.insert(missionPaths.end(), archivedMissionPaths.begin(), archivedMissionPaths.end());
+		}
 		else if (XFile::IsFile(argument)) {
 			missionPaths.push_back(argument);
 		}
@@ -103,6 +417,75 @@ std::vector<std::string> FindMissionPaths(const std::vector<std::string>& argume
 	return missionPaths;
 }
 
+// Paths are supplied in the same order as sorting all paths would produce,
+// so rows can be written while directories are still being searched, and only one directory's entries are held at a time
+void FindMissionPathsSorted(std::vector<std::string> arguments, bool recursive, const MissionPathSink& addMissionPath)
+{
+	std::sort(arguments.begin(), arguments.end(), [](const std::string& a, const std::string& b) {
+		return GetPathSortKey(a, XFile::IsDirectory(a)) < GetPathSortKey(b, XFile::IsDirectory(b));
+	});
+
+	for (const auto& argument : arguments)
+	{
+		if (XFile::IsDirectory(argument)) {
+			FindDirectoryMissionPathsSorted(argument, recursive, addMissionPath);
+		}
+		else if (IsArchiveFile(argument)) {
+			auto archivedMissionPaths = FindArchivedMissionPaths(argument);
+			std::sort(archivedMissionPaths.begin(), archivedMissionPaths.end());
+			for (auto& missionPath : archivedMissionPaths) {
+				addMissionPath(std::move(missionPath));
+			}
+		}
+		else {
+			addMissionPath(argument);
+		}
+	}
+}
+
+// Entries of each directory are visited in sorted order, descending into subdirectories as they are reached when recursive.
+// Symbolic links to directories are not followed, to avoid cycles.
+void FindDirectoryMissionPathsSorted(const fs::path& directory, bool recursive, const MissionPathSink& addMissionPath)
+{
+	std::vector<std::pair<std::string, fs::path>> entries;
+
+	std::error_code errorCode;
+	for (fs::directory_iterator it(directory, errorCode), end; !errorCode && it != end; it.increment(errorCode))
+	{
+		const auto& path = it->path();
+		const bool isDirectory = fs::is_directory(it->symlink_status());
+
+		if ((isDirectory && recursive) || (XFile::ExtensionMatches(path.string(), ".dll") && fs::is_regular_file(it->status()))) {
+			entries.emplace_back(GetPathSortKey(path.filename(), isDirectory), path);
+		}
+	}
+
+	if (errorCode) {
+		std::cerr << "Error searching directory: " << directory.string() << " : " << errorCode.message() << std::endl;
+	}
+
+	std::sort(entries.begin(), entries.end());
+
+	for (const auto& entry : entries) {
+		if (entry.first.back() == '/') {
+			FindDirectoryMissionPathsSorted(entry.second, recursive, addMissionPath);
+		}
+		else {
+			addMissionPath(entry.second.string());
+		}
+	}
+}
+
+// A trailing separator on directories makes sibling order match the sort order of the full paths beneath them
+std::string GetPathSortKey(const fs::path& path, bool isDirectory)
+{
+	auto sortKey = path.string();
+	if (isDirectory) {
+		sortKey += '/';
+	}
+	return sortKey;
+}
+
 void OutputHelp()
 {
 	std::cout << std::endl;
@@ -112,11 +495,26 @@ void OutputHelp()
 	std::cout << "Review the publically exported infromation contained in Outpost 2 mission DLLs" << std::endl;
 	std::cout << std::endl;
 	std::cout << "+++ COMMANDS +++" << std::endl;
-	std::cout << "  * MissionScanner (archivename.(vol|clm) | directory)... [-L]" << std::endl;
+	std::cout << "  * MissionScanner (archivename.(vol|clm) | directory)... [-L] [-R] [-J N] [--QueueDepth N] [--MaxMemory MiB] [-C cachefile] [-D] [-E] [-F format] [-S] [-W] [--Where condition]... [--SortBy fields] [--Serve socket]" << std::endl;
 	std::cout << std::endl;
 	std::cout << "+++ OPTIONAL ARGUMENTS +++" << std::endl;
 	std::cout << "  -H / --Help / -?: Displays help information." << std::endl;
 	std::cout << "  -L / --Legend: Remove legend." << std::endl;
+	std::cout << "  -R / --Recursive: Search subdirectories, writing rows while the search continues." << std::endl;
+	std::cout << "  -J / --Jobs N: Number of DLLs to parse concurrently. Defaults to hardware thread count." << std::endl;
+	std::cout << "  --QueueDepth N: Keep header reads of up to N DLLs in flight with io_uring, ahead of parsing. Falls back to blocking reads where io_uring is unavailable. Linux only." << std::endl;
+	std::cout << "  --MaxMemory MiB: Bound memory for paths and sorted rows. Paths are found one directory at a time, and rows sorted by --SortBy spill to temporary files." << std::endl;
+	std::cout << "  -C / --Cache cachefile: Reuse details of unchanged DLLs parsed by a previous run." << std::endl;
+	std::cout << "  --NoCache: Ignore any cache file and parse every DLL." << std::endl;
+	std::cout << "  -D / --Dedupe: Parse DLLs with identical content once. Copies are listed after the table, or marked with duplicateOf." << std::endl;
+	std::cout << "  -S / --Stats: Write scan timings and read counters to stderr after the table." << std::endl;
+	std::cout << "  --StatsFile filename: Write scan timings and read counters to a JSON file instead." << std::endl;
+	std::cout << "  -F / --Format format: Output format of text (default), csv, jsonl or bin. Legend is only written for text." << std::endl;
+	std::cout << "  -E / --Exports: List every export of each DLL with its ordinal, RVA, section and forwarder, instead of the mission table." << std::endl;
+	std::cout << "  --Where condition: Only write missions matching field, operator (= != < <= > >= ~) and value, such as numPlayers>=4 or levelDesc~colony. Repeat to require several." << std::endl;
+	std::cout << "  --SortBy fields: Sort rows by comma separated fields, prefixed with - for descending, such as missionType,-numPlayers." << std::endl;
+	std::cout << "  -W / --Watch: After the table, write add, update and remove events as JSON lines as DLLs in the directories change. Defaults format to jsonl. Linux only." << std::endl;
+	std::cout << "  --Serve socket: Keep the missions in memory, answering list, get, status and rescan requests over a Unix domain socket instead of writing the table." << std::endl;
 	std::cout << std::endl;
 	std::cout << "For more information about Outpost 2, visit the Outpost Universe website at http://outpost2.net." << std::endl;
 	std::cout << std::endl;
@@ -0,0 +1,382 @@
+#include "MissionServer.h"
+#include "MissionScan.h"
+#include "OutputBuffer.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <system_error>
+#include <chrono>
+#include <array>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+std::string FormatErrorResponse(std::string_view message);
+
+
+#ifndef _WIN32
+
+// A client sending more than this without a line break is disconnected
+constexpr std::size_t maxRequestSize = 64 * 1024;
+
+bool SendAll(int descriptor, std::string_view data);
+
+MissionServer::MissionServer(std::string socketPath, MissionPathSource missionPathSource, ScanOptions scanOptions) :
+	socketPath(std::move(socketPath)),
+	missionPathSource(std::move(missionPathSource)),
+	scanOptions(std::move(scanOptions))
+{
+}
+
+// Connections are stopped first, as a request may start another rescan
+MissionServer::~MissionServer()
+{
+	for (auto& connection : connections) {
+		shutdown(connection.descriptor, SHUT_RDWR);
+	}
+	for (auto& connection : connections) {
+		connection.thread.join();
+		close(connection.descriptor);
+	}
+
+	if (rescanThread.joinable()) {
+		rescanThread.join();
+	}
+
+	if (listenDescriptor >= 0) {
+		close(listenDescriptor);
+		unlink(socketPath.c_str());
+	}
+}
+
+void MissionServer::Run()
+{
+	// Clients connecting during the initial scan wait in the listen backlog
+	Listen();
+	Rescan();
+	std::cerr << "Serving " << GetCatalog()->Size() << " missions on " << socketPath << std::endl;
+
+	while (true) {
+		const int connectionDescriptor = accept4(listenDescriptor, nullptr, nullptr, SOCK_CLOEXEC);
+		if (connectionDescriptor < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			throw std::runtime_error("Unable to accept connection : " + std::string(std::strerror(errno)));
+		}
+
+		JoinFinishedConnections();
+
+		auto& connection = connections.emplace_back();
+		connection.descriptor = connectionDescriptor;
+		try {
+			connection.thread = std::thread([this, &connection] {
+				ServeConnection(connection.descriptor);
+				connection.isFinished = true;
+			});
+		}
+		catch (const std::system_error& e) {
+			close(connectionDescriptor);
+			connections.pop_back();
+			std::cerr << "Unable to serve connection : " << e.what() << std::endl;
+		}
+	}
+}
+
+void MissionServer::JoinFinishedConnections()
+{
+	for (auto connection = connections.begin(); connection != connections.end();) {
+		if (!connection->isFinished) {
+			++connection;
+			continue;
+		}
+		connection->thread.join();
+		close(connection->descriptor);
+		connection = connections.erase(connection);
+	}
+}
+
+void MissionServer::Listen()
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("Invalid socket path : " + socketPath);
+	}
+	socketPath.copy(address.sun_path, socketPath.size());
+	const auto* socketAddress = reinterpret_cast<const sockaddr*>(&address);
+
+	// A socket file left by a server that exited is replaced. One still accepting connections is not.
+	struct stat fileStatus;
+	if (lstat(socketPath.c_str(), &fileStatus) == 0 && S_ISSOCK(fileStatus.st_mode)) {
+		const int probeDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		const bool isServed = probeDescriptor >= 0 && connect(probeDescriptor, socketAddress, sizeof(address)) == 0;
+		if (probeDescriptor >= 0) {
+			close(probeDescriptor);
+		}
+		if (isServed) {
+			throw std::runtime_error("Socket is already being served : " + socketPath);
+		}
+		unlink(socketPath.c_str());
+	}
+
+	const int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (descriptor < 0) {
+		throw std::runtime_error("Unable to create socket : " + std::string(std::strerror(errno)));
+	}
+
+	if (bind(descriptor, socketAddress, sizeof(address)) < 0) {
+		const auto bindError = errno;
+		close(descriptor);
+		throw std::runtime_error("Unable to bind socket : " + socketPath + " : " + std::strerror(bindError));
+	}
+	listenDescriptor = descriptor;
+
+	if (listen(listenDescriptor, SOMAXCONN) < 0) {
+		throw std::runtime_error("Unable to listen on socket : " + socketPath + " : " + std::strerror(errno));
+	}
+}
+
+// Requests are answered in order. Several requests may be pipelined on one connection.
+// The socket is left open for the accepting thread to close once this thread is joined.
+void MissionServer::ServeConnection(int connectionDescriptor)
+{
+	try {
+		std::string received;
+		std::array<char, 4096> block;
+
+		while (true) {
+			const auto byteCount = recv(connectionDescriptor, block.data(), block.size(), 0);
+			if (byteCount < 0 && errno == EINTR) {
+				continue;
+			}
+			if (byteCount <= 0) {
+				break;
+			}
+			received.append(block.data(), byteCount);
+
+			std::string responses;
+			std::size_t lineStart = 0;
+			for (auto lineEnd = received.find('\n'); lineEnd != std::string::npos; lineEnd = received.find('\n', lineStart)) {
+				auto request = std::string_view(received).substr(lineStart, lineEnd - lineStart);
+				if (!request.empty() && request.back() == '\r') {
+					request.remove_suffix(1);
+				}
+				responses += AnswerRequest(request);
+				lineStart = lineEnd + 1;
+			}
+			received.erase(0, lineStart);
+
+			if (received.size() > maxRequestSize) {
+				SendAll(connectionDescriptor, responses + FormatErrorResponse("Request is too long"));
+				break;
+			}
+			if (!SendAll(connectionDescriptor, responses)) {
+				break;
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Connection closed : " << e.what() << std::endl;
+	}
+}
+
+#else
+
+MissionServer::MissionServer(std::string socketPath, MissionPathSource missionPathSource, ScanOptions scanOptions) :
+	socketPath(std::move(socketPath)),
+	missionPathSource(std::move(missionPathSource)),
+	scanOptions(std::move(scanOptions))
+{
+	throw std::runtime_error("Serving over a Unix domain socket is not supported on Windows");
+}
+
+MissionServer::~MissionServer()
+{
+}
+
+void MissionServer::Run()
+{
+}
+
+void MissionServer::Listen()
+{
+}
+
+void MissionServer::ServeConnection(int)
+{
+}
+
+void MissionServer::JoinFinishedConnections()
+{
+}
+
+#endif
+
+
+std::shared_ptr<const MissionCatalog> MissionServer::GetCatalog()
+{
+	std::lock_guard<std::mutex> lock(catalogMutex);
+	return catalog;
+}
+
+// Rows that could not be opened are reported to std::cerr and left out of the catalog
+void MissionServer::Rescan()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<MissionRow> rows;
+	ScanMissionRows(missionPathSource, scanOptions, [&rows](MissionRow& row) {
+		if (!row.openError.empty()) {
+			std::cerr << "Error opening DLL: " << row.path << " : " << row.openError << std::endl;
+		}
+		else if (IsRowSelected(row)) {
+			rows.push_back(std::move(row));
+		}
+	});
+
+	auto newCatalog = std::make_shared<const MissionCatalog>(std::move(rows));
+	const auto duration = std::chrono::steady_clock::now() - startTime;
+
+	{
+		std::lock_guard<std::mutex> lock(catalogMutex);
+		catalog.swap(newCatalog);
+		++generation;
+		scanMilliseconds = std::chrono::duration<double, std::milli>(duration).count();
+	}
+	// The previous catalog is released outside the lock, once requests still using it finish
+}
+
+// Returns false if a rescan is already running
+bool MissionServer::StartRescan()
+{
+	std::lock_guard<std::mutex> lock(rescanMutex);
+	if (isRescanning) {
+		return false;
+	}
+
+	if (rescanThread.joinable()) {
+		rescanThread.join();
+	}
+
+	isRescanning = true;
+	rescanThread = std::thread([this] {
+		try {
+			Rescan();
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Rescan failed, keeping the previous catalog : " << e.what() << std::endl;
+		}
+		isRescanning = false;
+	});
+	return true;
+}
+
+std::string MissionServer::AnswerRequest(std::string_view request)
+{
+	const auto commandEnd = request.find(' ');
+	const auto command = request.substr(0, commandEnd);
+	const auto argument = commandEnd == std::string_view::npos ? std::string_view() : request.substr(commandEnd + 1);
+
+	try {
+		std::string response;
+
+		if (command == "list") {
+			// Conditions are separated by &, as values such as descriptions may contain spaces
+			MissionFilter missionFilter;
+			auto conditions = argument;
+			while (!conditions.empty()) {
+				const auto separatorOffset = conditions.find('&');
+				if (separatorOffset != 0) {
+					missionFilter.AddCondition(conditions.substr(0, separatorOffset));
+				}
+				if (separatorOffset == std::string_view::npos) {
+					break;
+				}
+				conditions.remove_prefix(separatorOffset + 1);
+			}
+
+			GetCatalog()->AppendMatches(missionFilter, response);
+		}
+		else if (command == "get") {
+			if (argument.empty()) {
+				throw std::runtime_error("Missing name to get");
+			}
+			GetCatalog()->AppendNamed(argument, response);
+		}
+		else if (command == "status") {
+			response = AnswerStatus();
+		}
+		else if (command == "rescan") {
+			response = StartRescan() ? "{\"rescan\":\"started\"}\n" : "{\"rescan\":\"running\"}\n";
+		}
+		else {
+			throw std::runtime_error("Unknown request : " + std::string(command));
+		}
+
+		response += '\n';
+		return response;
+	}
+	catch (const std::exception& e) {
+		return FormatErrorResponse(e.what());
+	}
+}
+
+std::string MissionServer::AnswerStatus()
+{
+	std::ostringstream stream;
+	std::lock_guard<std::mutex> lock(catalogMutex);
+
+	stream << "{\"missions\":" << catalog->Size();
+	stream << ",\"generation\":" << generation;
+	stream << ",\"scanMilliseconds\":" << std::fixed << std::setprecision(3) << scanMilliseconds;
+	stream << ",\"rescanning\":" << (isRescanning ? "true" : "false");
+	stream << "}" << std::endl;
+	return stream.str();
+}
+
+
+// Complete response, including the empty line ending it
+std::string FormatErrorResponse(std::string_view message)
+{
+	std::ostringstream stream;
+	{
+		OutputBuffer output(stream, 256);
+		output.Write("{\"error\":");
+		WriteJsonString(output, message);
+		output.Write('}');
+		output.EndLine();
+		output.EndLine();
+	}
+	return stream.str();
+}
+
+#ifndef _WIN32
+
+// Returns false once the client has disconnected
+bool SendAll(int descriptor, std::string_view data)
+{
+	while (!data.empty()) {
+		// MSG_NOSIGNAL, so a client disconnecting mid response does not raise SIGPIPE
+		const auto byteCount = send(descriptor, data.data(), data.size(), MSG_NOSIGNAL);
+		if (byteCount < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data.remove_prefix(byteCount);
+	}
+
+	return true;
+}
+
+#endif
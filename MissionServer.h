@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MissionCatalog.h"
+#include "MissionTable.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+
+// Answers mission queries over a Unix domain socket from a catalog held in memory.
+// Each request is one line, answered by zero or more JSON lines and then an empty line:
+//   list [condition[&condition]...]   Missions matching every condition, in --where syntax
+//   get name                          Missions with the DLL name, ignoring case and without extension
+//   status                            Catalog size, generation and whether a rescan is running
+//   rescan                            Starts rescanning in the background, then swaps in the new catalog
+// Requests are answered from the current catalog while a rescan runs.
+class MissionServer
+{
+public:
+	// Paths are found again from the source on each rescan
+	MissionServer(std::string socketPath, MissionPathSource missionPathSource, ScanOptions scanOptions);
+	~MissionServer();
+
+	MissionServer(const MissionServer&) = delete;
+	MissionServer& operator=(const MissionServer&) = delete;
+
+	// Builds the catalog, then serves connections until the process is stopped
+	void Run();
+
+private:
+	std::string socketPath;
+	MissionPathSource missionPathSource;
+	ScanOptions scanOptions;
+	int listenDescriptor = -1;
+
+	// Guards swapping the catalog and its details. Requests hold a reference to the catalog, not the lock.
+	std::mutex catalogMutex;
+	std::shared_ptr<const MissionCatalog> catalog;
+	std::uint64_t generation = 0;
+	double scanMilliseconds = 0;
+
+	// Guards starting and joining the rescan thread
+	std::mutex rescanMutex;
+	std::atomic<bool> isRescanning{ false };
+	std::thread rescanThread;
+
+	// Each connection is served on its own thread. Only the accepting thread and the destructor touch the list.
+	// The socket is closed once the thread is joined, so the destructor can shut it down without racing a reused descriptor.
+	struct Connection
+	{
+		int descriptor = -1;
+		std::thread thread;
+		std::atomic<bool> isFinished{ false };
+	};
+	std::list<Connection> connections;
+
+	std::shared_ptr<const MissionCatalog> GetCatalog();
+	void Rescan();
+	bool StartRescan();
+	void Listen();
+	void ServeConnection(int connectionDescriptor);
+	void JoinFinishedConnections();
+	std::string AnswerRequest(std::string_view request);
+	std::string AnswerStatus();
+};
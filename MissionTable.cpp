@@ -1,32 +1,131 @@
 #include "MissionTable.h"
-#include "DllExportReader32.h"
+#include "MissionScan.h"
+#include "MissionRow.h"
+#include "ScanStats.h"
+#include "OutputBuffer.h"
+#include "BinaryRowFormat.h"
 #include "Outpost2DllExportedDefinitions.h"
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string_view>
 #include <stdexcept>
 #include <cstddef>
 #include <array>
 #include <algorithm>
-
-#ifdef __cpp_lib_filesystem
-#include <filesystem>
-namespace fs = std::filesystem;
-#else
-#include <experimental/filesystem>
-namespace fs = std::experimental::filesystem;
+#include <optional>
+#include <unordered_map>
+#include <exception>
+#include <memory>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
 #endif
 
 
-void WriteHeader();
-void WriteRow(DllExportReader32& dllReader, std::string_view filename);
+// Receives scanned missions in output order, and formats them into the output buffer
+class RowSink
+{
+public:
+	explicit RowSink(std::ostream& stream) : output(stream) { }
+	virtual ~RowSink() = default;
+
+	// Called once, before the first row
+	virtual void Begin() = 0;
+	virtual void WriteRow(const MissionRow& row) = 0;
+
+	// Called once after the last row, if there were any
+	virtual void End() { }
+
+	// Hands buffered output to the stream, so it is ordered before messages written to std::cerr
+	void Flush() { output.Flush(); }
+
+protected:
+	OutputBuffer output;
+
+	void WriteReadError(const MissionRow& row);
+};
+
+// Fixed width table for reading in a console
+class TextRowSink : public RowSink
+{
+public:
+	TextRowSink(std::ostream& stream, bool writeLegend) : RowSink(stream), writeLegend(writeLegend) { }
+	void Begin() override;
+	void WriteRow(const MissionRow& row) override;
+
+	// Lists the paths of duplicate DLLs after the table, grouped by the first DLL with the same content
+	void End() override;
+
+private:
+	bool writeLegend;
+	std::vector<std::pair<std::string, std::vector<std::string>>> duplicateGroups;
+	std::unordered_map<std::string, std::size_t> duplicateGroupIndices;
+};
+
+// RFC 4180 comma separated values, with a header row naming each field
+class CsvRowSink : public RowSink
+{
+public:
+	CsvRowSink(std::ostream& stream, bool writeDuplicateOf) : RowSink(stream), writeDuplicateOf(writeDuplicateOf) { }
+	void Begin() override;
+	void WriteRow(const MissionRow& row) override;
+
+private:
+	// Column is only included when deduplicating, so the default layout is unchanged
+	bool writeDuplicateOf;
+
+	void WriteField(std::string_view value);
+	void WriteField(int value);
+	void WriteOptionalField(const std::optional<std::string>& value);
+};
+
+// One JSON object per mission per line, so consumers can process missions as they are written
+class JsonLinesRowSink : public RowSink
+{
+public:
+	// Read errors are always included as an error member. They are also written to std::cerr unless disabled.
+	explicit JsonLinesRowSink(std::ostream& stream, bool writeReadErrors = true) : RowSink(stream), writeReadErrors(writeReadErrors) { }
+	void Begin() override { }
+	void WriteRow(const MissionRow& row) override;
+
+	// Same members as WriteRow, following an "event" member
+	void WriteEvent(std::string_view eventName, const MissionRow& row, bool includeDetails);
+
+private:
+	bool writeReadErrors;
+
+	void WriteRowMembers(const MissionRow& row, bool includeDetails);
+	void WriteString(std::string_view value);
+	void WriteMember(std::string_view name, std::string_view value);
+	void WriteMember(std::string_view name, int value);
+	void WriteOptionalMember(std::string_view name, const std::optional<std::string>& value);
+};
 
-void WriteCell(std::string_view message, std::streamsize cellWidthInChars);
-void WriteCell(int integer, std::streamsize cellWidthInChars);
-void WriteCell(MissionTypes missionType, std::streamsize cellWidthInChars);
-void WriteBoolCell(bool boolean, std::streamsize cellWidthInChars);
+// Length prefixed records described in BinaryRowFormat.h
+class BinaryRowSink : public RowSink
+{
+public:
+	explicit BinaryRowSink(std::ostream& stream);
+	void Begin() override;
+	void WriteRow(const MissionRow& row) override;
+
+private:
+	void WriteString(const std::optional<std::string>& value);
+	void WriteLittleEndian(std::uint32_t value);
+};
+
+std::unique_ptr<RowSink> CreateRowSink(const ScanOptions& scanOptions);
+std::string_view GetMissionEventName(MissionEvent missionEvent);
 
-std::string_view ConvertMissionTypeToString(MissionTypes missionType);
+
+void WriteCell(OutputBuffer& output, std::string_view message, std::size_t cellWidthInChars);
+void WriteCell(OutputBuffer& output, int integer, std::size_t cellWidthInChars);
+void WriteCell(OutputBuffer& output, MissionTypes missionType, std::size_t cellWidthInChars);
+void WriteBoolCell(OutputBuffer& output, bool boolean, std::size_t cellWidthInChars);
 
 struct LegendEntry
 {
@@ -44,7 +143,7 @@ constexpr std::array<LegendEntry, 7> columnTitles{
 	LegendEntry {"MISSION DESCRIPTION", "Description of the mission displayed in Outpost 2"}
 };
 
-constexpr std::array<std::streamsize, 7> columnWidths{ 9, 4, 2, 2, 18, 24, 1 };
+constexpr std::array<std::size_t, 7> columnWidths{ 9, 4, 2, 2, 18, 24, 1 };
 
 constexpr std::array<LegendEntry, 9> missionTypes{
 	// Campaign (positive missionType values)
@@ -90,85 +189,479 @@ void WriteLegend()
 	WriteLegendPortion("MISSION TYPE LEGEND", missionTypes);
 }
 
-void WriteTable(std::vector<std::string> missionPaths)
+void WriteTable(std::vector<std::string> missionPaths, const ScanOptions& scanOptions)
 {
-	WriteHeader();
-
 	std::sort(missionPaths.begin(), missionPaths.end());
-	for (const auto& missionPath : missionPaths)
-	{
-		try {
-			DllExportReader32 dllExportedVariables(missionPath);
 
-			if (!dllExportedVariables.DoesExportExist("LevelDesc")) {
-				continue;
+	WriteTable([&missionPaths](const MissionPathSink& addMissionPath) {
+		for (auto& missionPath : missionPaths) {
+			addMissionPath(std::move(missionPath));
+		}
+	}, scanOptions);
+}
+
+void WriteTable(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions)
+{
+	// Rows are formatted into a buffer and written in large blocks
+	auto rowSink = CreateRowSink(scanOptions);
+	bool isBegun = false;
+
+	// Output is still completed and flushed if the source fails
+	std::exception_ptr scanException;
+	try {
+		ScanMissionRows(missionPathSource, scanOptions, [&](const MissionRow& row) {
+			// Nothing is written unless at least one DLL was found
+			if (!isBegun) {
+				rowSink->Begin();
+				isBegun = true;
 			}
 
-			WriteRow(dllExportedVariables, fs::path(missionPath).filename().replace_extension().string());
-		}
-		catch (const std::exception & e) {
-			std::cerr << "Error opening DLL: " << missionPath << " : " << e.what() << std::endl;
-		}
+			if (!row.openError.empty()) {
+				rowSink->Flush();
+				std::cerr << "Error opening DLL: " << row.path << " : " << row.openError << std::endl;
+			}
+			else if (IsRowSelected(row)) {
+				rowSink->WriteRow(row);
+			}
+		});
+	}
+	catch (...) {
+		scanException = std::current_exception();
+	}
+
+	const auto flushStartTime = ScanStats::Clock::now();
+	if (isBegun) {
+		rowSink->End();
+	}
+	rowSink->Flush();
+	std::cout.flush();
+	if (scanOptions.scanStats) {
+		scanOptions.scanStats->AddWriteOutputTime(ScanStats::Clock::now() - flushStartTime);
+	}
+
+	if (scanException) {
+		std::rethrow_exception(scanException);
 	}
 }
 
-void WriteHeader()
+OutputFormat ParseOutputFormat(const std::string& formatName)
 {
+	if (formatName == "text") {
+		return OutputFormat::Text;
+	}
+	if (formatName == "csv") {
+		return OutputFormat::Csv;
+	}
+	if (formatName == "jsonl") {
+		return OutputFormat::JsonLines;
+	}
+	if (formatName == "bin") {
+		return OutputFormat::Binary;
+	}
+
+	throw std::runtime_error("Unknown output format : " + formatName);
+}
+
+std::string FormatJsonLine(const MissionRow& row)
+{
+	std::ostringstream stream;
+	JsonLinesRowSink rowSink(stream, false);
+	rowSink.WriteRow(row);
+	rowSink.Flush();
+	return stream.str();
+}
+
+void WriteMissionEvent(MissionEvent missionEvent, const MissionRow& row)
+{
+	JsonLinesRowSink rowSink(std::cout);
+	rowSink.WriteEvent(GetMissionEventName(missionEvent), row, missionEvent != MissionEvent::Remove);
+	rowSink.Flush();
+	std::cout.flush();
+}
+
+std::string_view GetMissionEventName(MissionEvent missionEvent)
+{
+	switch (missionEvent)
+	{
+	case MissionEvent::Add:
+		return "add";
+	case MissionEvent::Update:
+		return "update";
+	default:
+		return "remove";
+	}
+}
+
+std::unique_ptr<RowSink> CreateRowSink(const ScanOptions& scanOptions)
+{
+	switch (scanOptions.outputFormat)
+	{
+	case OutputFormat::Csv:
+		return std::make_unique<CsvRowSink>(std::cout, scanOptions.dedupe);
+	case OutputFormat::JsonLines:
+		return std::make_unique<JsonLinesRowSink>(std::cout);
+	case OutputFormat::Binary:
+		return std::make_unique<BinaryRowSink>(std::cout);
+	default:
+		return std::make_unique<TextRowSink>(std::cout, scanOptions.writeLegend);
+	}
+}
+
+void RowSink::WriteReadError(const MissionRow& row)
+{
+	if (!row.readError.empty()) {
+		Flush();
+		std::cerr << "Error attempting to write mission details for " << row.filename << ". " << row.readError << std::endl;
+	}
+}
+
+
+void TextRowSink::Begin()
+{
+	// Legend is written directly to std::cout, before anything is buffered
+	if (writeLegend) {
+		WriteLegend();
+	}
+
 	for (std::size_t i = 0; i < columnTitles.size(); ++i) {
-		WriteCell(columnTitles[i].key, columnWidths[i]);
+		WriteCell(output, columnTitles[i].key, columnWidths[i]);
 	}
-	std::cout << std::endl;
+	output.EndLine();
 }
 
-void WriteRow(DllExportReader32& dllReader, std::string_view filename)
+void TextRowSink::WriteRow(const MissionRow& row)
 {
 	try 
 	{
-		WriteCell(filename, columnWidths[0]);
+		WriteCell(output, row.filename, columnWidths[0]);
 
-		auto aiModDesc = dllReader.ReadExport<AIModDesc>("DescBlock");
-		WriteCell(static_cast<MissionTypes>(aiModDesc.missionType), columnWidths[1]);
-		WriteCell(aiModDesc.numPlayers, columnWidths[2]);
-		WriteBoolCell(static_cast<bool>(aiModDesc.boolUnitMission), columnWidths[3]);
+		if (row.aiModDesc) {
+			WriteCell(output, static_cast<MissionTypes>(row.aiModDesc->missionType), columnWidths[1]);
+			WriteCell(output, row.aiModDesc->numPlayers, columnWidths[2]);
+			WriteBoolCell(output, static_cast<bool>(row.aiModDesc->boolUnitMission), columnWidths[3]);
+		}
+		if (row.mapName) {
+			WriteCell(output, *row.mapName, columnWidths[4]);
+		}
+		if (row.techtreeName) {
+			WriteCell(output, *row.techtreeName, columnWidths[5]);
+		}
+		if (row.levelDesc) {
+			WriteCell(output, *row.levelDesc, columnWidths[6]);
+		}
 
-		// Some missions do not store LevelDesc, MapName, and TechTreeName within AIModDesc
-		WriteCell(dllReader.ReadExportString("MapName"), columnWidths[4]);
-		WriteCell(dllReader.ReadExportString("TechtreeName"), columnWidths[5]);
-		WriteCell(dllReader.ReadExportString("LevelDesc"), columnWidths[6]);
+		if (!row.readError.empty()) {
+			output.Flush();
+			std::cerr << "Error attempting to write mission details for " << row.filename << ". " << row.readError;
+		}
 	}
 	catch (const std::exception& e) 
 	{
-		std::cerr << "Error attempting to write mission details for " << filename << ". " << e.what();
+		output.Flush();
+		std::cerr << "Error attempting to write mission details for " << row.filename << ". " << e.what();
 	}
 
-	std::cout << std::endl;
+	output.EndLine();
+
+	if (!row.duplicateOf.empty()) {
+		const auto groupIndex = duplicateGroupIndices.emplace(row.duplicateOf, duplicateGroups.size()).first->second;
+		if (groupIndex == duplicateGroups.size()) {
+			duplicateGroups.emplace_back(row.duplicateOf, std::vector<std::string>());
+		}
+		duplicateGroups[groupIndex].second.push_back(row.path);
+	}
+}
+
+void TextRowSink::End()
+{
+	if (duplicateGroups.empty()) {
+		return;
+	}
+
+	output.EndLine();
+	output.Write("DUPLICATE MISSION DLLS");
+	output.EndLine();
+	for (const auto& duplicateGroup : duplicateGroups) {
+		output.Write(duplicateGroup.first);
+		output.EndLine();
+		for (const auto& duplicatePath : duplicateGroup.second) {
+			output.Write("  ");
+			output.Write(duplicatePath);
+			output.EndLine();
+		}
+	}
 }
 
 
+void CsvRowSink::Begin()
+{
+	output.Write("path,name,missionType,numPlayers,maxTechLevel,boolUnitMission,checksum,mapName,techtreeName,levelDesc");
+	if (writeDuplicateOf) {
+		output.Write(",duplicateOf");
+	}
+	output.EndLine();
+}
+
+// Fields missing because of a read error are left empty
+void CsvRowSink::WriteRow(const MissionRow& row)
+{
+	WriteField(row.path);
+	output.Write(',');
+	WriteField(row.filename);
+
+	for (auto field : { &AIModDesc32::missionType, &AIModDesc32::numPlayers, &AIModDesc32::maxTechLevel, &AIModDesc32::boolUnitMission, &AIModDesc32::checksum }) {
+		output.Write(',');
+		if (row.aiModDesc) {
+			WriteField((*row.aiModDesc).*field);
+		}
+	}
+
+	output.Write(',');
+	WriteOptionalField(row.mapName);
+	output.Write(',');
+	WriteOptionalField(row.techtreeName);
+	output.Write(',');
+	WriteOptionalField(row.levelDesc);
+	if (writeDuplicateOf) {
+		output.Write(',');
+		WriteField(row.duplicateOf);
+	}
+	output.EndLine();
+
+	WriteReadError(row);
+}
+
+void CsvRowSink::WriteField(std::string_view value)
+{
+	WriteCsvField(output, value);
+}
+
+void CsvRowSink::WriteField(int value)
+{
+	output.WriteInteger(value);
+}
+
+void CsvRowSink::WriteOptionalField(const std::optional<std::string>& value)
+{
+	if (value) {
+		WriteField(*value);
+	}
+}
+
+
+void JsonLinesRowSink::WriteRow(const MissionRow& row)
+{
+	output.Write('{');
+	WriteRowMembers(row, true);
+	output.Write('}');
+	output.EndLine();
+
+	if (writeReadErrors) {
+		WriteReadError(row);
+	}
+}
+
+void JsonLinesRowSink::WriteEvent(std::string_view eventName, const MissionRow& row, bool includeDetails)
+{
+	output.Write('{');
+	WriteMember("event", eventName);
+	output.Write(',');
+	WriteRowMembers(row, includeDetails);
+	output.Write('}');
+	output.EndLine();
+
+	if (includeDetails) {
+		WriteReadError(row);
+	}
+}
+
+// Strings missing because of a read error are null, and the error is included
+void JsonLinesRowSink::WriteRowMembers(const MissionRow& row, bool includeDetails)
+{
+	WriteMember("path", row.path);
+	output.Write(',');
+	WriteMember("name", row.filename);
+
+	if (!includeDetails) {
+		return;
+	}
+
+	if (row.aiModDesc) {
+		output.Write(',');
+		WriteMember("missionType", row.aiModDesc->missionType);
+		output.Write(',');
+		WriteMember("numPlayers", row.aiModDesc->numPlayers);
+		output.Write(',');
+		WriteMember("maxTechLevel", row.aiModDesc->maxTechLevel);
+		output.Write(',');
+		WriteMember("boolUnitMission", row.aiModDesc->boolUnitMission);
+		output.Write(',');
+		WriteMember("checksum", row.aiModDesc->checksum);
+	}
+
+	output.Write(',');
+	WriteOptionalMember("mapName", row.mapName);
+	output.Write(',');
+	WriteOptionalMember("techtreeName", row.techtreeName);
+	output.Write(',');
+	WriteOptionalMember("levelDesc", row.levelDesc);
+
+	if (!row.readError.empty()) {
+		output.Write(',');
+		WriteMember("error", row.readError);
+	}
+
+	if (!row.duplicateOf.empty()) {
+		output.Write(',');
+		WriteMember("duplicateOf", row.duplicateOf);
+	}
+}
 
-void WriteCell(std::string_view message, std::streamsize cellWidthInChars)
+void JsonLinesRowSink::WriteString(std::string_view value)
 {
-	std::cout << std::setw(cellWidthInChars) << std::left << message;
+	WriteJsonString(output, value);
 }
 
-void WriteCell(int integer, std::streamsize cellWidthInChars)
+void JsonLinesRowSink::WriteMember(std::string_view name, std::string_view value)
 {
-	WriteCell(std::to_string(integer), cellWidthInChars);
+	WriteString(name);
+	output.Write(':');
+	WriteString(value);
 }
 
-void WriteCell(MissionTypes missionType, std::streamsize cellWidthInChars)
+void JsonLinesRowSink::WriteMember(std::string_view name, int value)
 {
-	WriteCell(ConvertMissionTypeToString(missionType), cellWidthInChars);
+	WriteString(name);
+	output.Write(':');
+	output.WriteInteger(value);
 }
 
-void WriteBoolCell(bool boolean, std::streamsize cellWidthInChars)
+void JsonLinesRowSink::WriteOptionalMember(std::string_view name, const std::optional<std::string>& value)
 {
-	std::string booleanString("T");
-	if (!boolean) {
-		booleanString = "F";
+	if (value) {
+		WriteMember(name, *value);
+		return;
 	}
 
-	WriteCell(booleanString, cellWidthInChars);
+	WriteString(name);
+	output.Write(":null");
+}
+
+
+BinaryRowSink::BinaryRowSink(std::ostream& stream) :
+	RowSink(stream)
+{
+#ifdef _WIN32
+	// Prevent newline translation from corrupting binary output written to std::cout
+	if (&stream == &std::cout) {
+		std::cout.flush();
+		_setmode(_fileno(stdout), _O_BINARY);
+	}
+#endif
+}
+
+void BinaryRowSink::Begin()
+{
+	output.Write(std::string_view(binaryRowSignature.data(), binaryRowSignature.size()));
+}
+
+void BinaryRowSink::WriteRow(const MissionRow& row)
+{
+	BinaryRowHeader header{};
+
+	header.timeDateStamp = row.timeDateStamp;
+	if (row.aiModDesc) {
+		header.flags |= BinaryRowHasAIModDesc;
+		header.missionType = row.aiModDesc->missionType;
+		header.numPlayers = row.aiModDesc->numPlayers;
+		header.maxTechLevel = row.aiModDesc->maxTechLevel;
+		header.boolUnitMission = row.aiModDesc->boolUnitMission;
+		header.checksum = row.aiModDesc->checksum;
+	}
+	if (row.mapName) {
+		header.flags |= BinaryRowHasMapName;
+	}
+	if (row.techtreeName) {
+		header.flags |= BinaryRowHasTechtreeName;
+	}
+	if (row.levelDesc) {
+		header.flags |= BinaryRowHasLevelDesc;
+	}
+
+	header.pathSize = static_cast<std::uint32_t>(row.path.size());
+	header.filenameSize = static_cast<std::uint32_t>(row.filename.size());
+	header.mapNameSize = static_cast<std::uint32_t>(row.mapName ? row.mapName->size() : 0);
+	header.techtreeNameSize = static_cast<std::uint32_t>(row.techtreeName ? row.techtreeName->size() : 0);
+	header.levelDescSize = static_cast<std::uint32_t>(row.levelDesc ? row.levelDesc->size() : 0);
+
+	// Each string is followed by a null terminator, then the record is padded to 4 byte alignment
+	const std::uint32_t unpaddedSize = sizeof(header) + header.pathSize + header.filenameSize + header.mapNameSize + header.techtreeNameSize + header.levelDescSize + 5;
+	header.recordSize = (unpaddedSize + 3) & ~std::uint32_t(3);
+
+	// Fields are written one at a time, so the output is little endian on any host
+	WriteLittleEndian(header.recordSize);
+	WriteLittleEndian(header.flags);
+	WriteLittleEndian(header.timeDateStamp);
+	WriteLittleEndian(static_cast<std::uint32_t>(header.missionType));
+	WriteLittleEndian(static_cast<std::uint32_t>(header.numPlayers));
+	WriteLittleEndian(static_cast<std::uint32_t>(header.maxTechLevel));
+	WriteLittleEndian(static_cast<std::uint32_t>(header.boolUnitMission));
+	WriteLittleEndian(static_cast<std::uint32_t>(header.checksum));
+	WriteLittleEndian(header.pathSize);
+	WriteLittleEndian(header.filenameSize);
+	WriteLittleEndian(header.mapNameSize);
+	WriteLittleEndian(header.techtreeNameSize);
+	WriteLittleEndian(header.levelDescSize);
+	WriteString(row.path);
+	WriteString(row.filename);
+	WriteString(row.mapName);
+	WriteString(row.techtreeName);
+	WriteString(row.levelDesc);
+	for (auto i = unpaddedSize; i < header.recordSize; ++i) {
+		output.Write('\0');
+	}
+
+	// Large blocks are still handed to the stream at record boundaries
+	output.EndRecord();
+
+	WriteReadError(row);
+}
+
+void BinaryRowSink::WriteString(const std::optional<std::string>& value)
+{
+	if (value) {
+		output.Write(*value);
+	}
+	output.Write('\0');
+}
+
+void BinaryRowSink::WriteLittleEndian(std::uint32_t value)
+{
+	for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+		output.Write(static_cast<char>((value >> (byteIndex * 8)) & 0xFF));
+	}
+}
+
+
+
+void WriteCell(OutputBuffer& output, std::string_view message, std::size_t cellWidthInChars)
+{
+	output.WritePadded(message, cellWidthInChars);
+}
+
+void WriteCell(OutputBuffer& output, int integer, std::size_t cellWidthInChars)
+{
+	output.WriteInteger(integer, cellWidthInChars);
+}
+
+void WriteCell(OutputBuffer& output, MissionTypes missionType, std::size_t cellWidthInChars)
+{
+	WriteCell(output, ConvertMissionTypeToString(missionType), cellWidthInChars);
+}
+
+void WriteBoolCell(OutputBuffer& output, bool boolean, std::size_t cellWidthInChars)
+{
+	WriteCell(output, boolean ? "T" : "F", cellWidthInChars);
 }
 
 
@@ -1,8 +1,89 @@
 #pragma once
 
+#include "MissionQuery.h"
+#include "Outpost2DllExportedDefinitions.h"
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstddef>
+#include <functional>
 
+class ScanStats;
+struct MissionRow;
+
+enum class OutputFormat
+{
+	Text,
+	Csv,
+	JsonLines,
+	Binary,
+};
+
+// Throws if the name does not match a format
+OutputFormat ParseOutputFormat(const std::string& formatName);
+
+struct ScanOptions
+{
+	OutputFormat outputFormat = OutputFormat::Text;
+
+	// Write legend before the table. Only applies to text output.
+	bool writeLegend = true;
+
+	// Number of DLLs parsed concurrently
+	std::size_t jobCount = 1;
+
+	// Header reads kept in flight with io_uring, ahead of the DLLs being parsed. Linux only.
+	// 0, or io_uring being unavailable, leaves each worker to read the headers of the DLL it parses.
+	std::size_t queueDepth = 0;
+
+	// Persistent cache of parsed rows. Empty to parse every DLL.
+	std::string cacheFilename;
+
+	// Only missions matching every condition are written. Conditions on AIModDesc are tested before any strings are read.
+	MissionFilter missionFilter;
+
+	// Rows are written in path order when empty. Otherwise rows are held until the scan finishes, then sorted.
+	MissionSortOrder sortOrder;
+
+	// Approximate bytes for paths in flight and rows held for sorting. 0 for no limit.
+	// When set, the source waits while too many paths are ahead of output, and sorted rows spill to temporary files.
+	std::size_t memoryLimit = 0;
+
+	// Parse DLLs with identical content once, marking later copies with the path of the first
+	bool dedupe = false;
+
+	// Collects per phase timers and read counters when set
+	ScanStats* scanStats = nullptr;
+
+	// Called on the writing thread for every scanned path, including DLLs that are not missions, in output order
+	std::function<void(const MissionRow& row)> rowScanned;
+};
+
+using MissionPathSink = std::function<void(std::string missionPath)>;
+using MissionPathSource = std::function<void(const MissionPathSink& addMissionPath)>;
+
+enum class MissionEvent
+{
+	Add,
+	Update,
+	Remove,
+};
 
 void WriteLegend();
-void WriteTable(std::vector<std::string> missionPaths);
+
+// Key shown in the TYP column, such as ML. Throws for unknown values.
+std::string_view ConvertMissionTypeToString(MissionTypes missionType);
+
+// Sorts paths before writing. Paths also order rows that are equal on every sort key.
+void WriteTable(std::vector<std::string> missionPaths, const ScanOptions& scanOptions);
+
+// DLLs are parsed while the source is still discovering paths.
+// Rows are written in the order the source supplies paths. See ScanMissions in MissionScan.h to receive rows without writing them.
+void WriteTable(const MissionPathSource& missionPathSource, const ScanOptions& scanOptions);
+
+// Row as jsonl output writes it, including the line ending. Read errors are only included as the error member.
+std::string FormatJsonLine(const MissionRow& row);
+
+// Writes a change to a watched mission as a single JSON line, and flushes it so consumers see it immediately.
+// Remove events only include the path and name.
+void WriteMissionEvent(MissionEvent missionEvent, const MissionRow& row);
@@ -0,0 +1,366 @@
+#include "MissionWatcher.h"
+#include "MissionTable.h"
+#include "MissionScan.h"
+#include "OP2Utility.h"
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+std::string GetDirectoryPrefix(const std::string& directory);
+bool IsBelowDirectory(const std::string& path, const std::string& directoryPrefix);
+
+
+#ifdef __linux__
+
+// Events arriving within this long of each other are handled as one batch,
+// so a file written or moved in several steps is only parsed once
+constexpr int settleMilliseconds = 100;
+
+// Attribute changes are ignored, so touching a file does not report an update.
+// Created files are reported when closed after writing, so only directory creation is needed.
+constexpr std::uint32_t watchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR;
+
+MissionWatcher::MissionWatcher(const std::vector<std::string>& directories, bool recursive) :
+	rootDirectories(directories),
+	recursive(recursive)
+{
+	inotifyDescriptor = inotify_init1(IN_CLOEXEC);
+	if (inotifyDescriptor < 0) {
+		throw std::runtime_error("Unable to watch for file changes : " + std::string(std::strerror(errno)));
+	}
+
+	try {
+		for (const auto& directory : directories) {
+			if (recursive) {
+				AddWatchRecursive(directory);
+			}
+			else {
+				AddWatch(directory);
+			}
+		}
+	}
+	catch (...) {
+		close(inotifyDescriptor);
+		throw;
+	}
+}
+
+MissionWatcher::~MissionWatcher()
+{
+	close(inotifyDescriptor);
+}
+
+void MissionWatcher::AddWatch(const std::string& directory)
+{
+	const int watchDescriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), watchMask);
+	if (watchDescriptor < 0) {
+		throw std::runtime_error("Unable to watch directory : " + directory + " : " + std::strerror(errno));
+	}
+
+	watchedDirectories[watchDescriptor] = directory;
+}
+
+// Symbolic links to directories are not followed, matching the recursive search
+void MissionWatcher::AddWatchRecursive(const std::string& directory)
+{
+	AddWatch(directory);
+
+	std::error_code errorCode;
+	for (fs::directory_iterator it(directory, errorCode), end; !errorCode && it != end; it.increment(errorCode)) {
+		if (fs::is_directory(it->symlink_status())) {
+			AddWatchRecursive(it->path().string());
+		}
+	}
+}
+
+// Blocks until at least one relevant event arrives, then gathers events until they settle.
+// Returns the affected paths sorted, so events are written in a predictable order.
+std::vector<std::string> MissionWatcher::ReadChangedPaths()
+{
+	std::vector<std::string> changedPaths;
+	alignas(inotify_event) std::array<char, 64 * 1024> buffer;
+
+	int timeout = -1;
+	while (true) {
+		pollfd pollDescriptor{ inotifyDescriptor, POLLIN, 0 };
+		const int readyCount = poll(&pollDescriptor, 1, timeout);
+		if (readyCount < 0 && errno == EINTR) {
+			continue;
+		}
+		if (readyCount < 0) {
+			throw std::runtime_error("Unable to wait for file changes : " + std::string(std::strerror(errno)));
+		}
+		if (readyCount == 0) {
+			break;
+		}
+
+		const auto bytesRead = read(inotifyDescriptor, buffer.data(), buffer.size());
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead <= 0) {
+			throw std::runtime_error("Unable to read file changes : " + std::string(std::strerror(errno)));
+		}
+
+		for (ssize_t offset = 0; offset < bytesRead; ) {
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			// Too many events were queued, so any file may have changed
+			if (event->mask & IN_Q_OVERFLOW) {
+				isOverflowed = true;
+				continue;
+			}
+
+			const auto watchedDirectory = watchedDirectories.find(event->wd);
+			if (watchedDirectory == watchedDirectories.end()) {
+				continue;
+			}
+
+			// Watch was removed, either explicitly or because the directory was deleted
+			if (event->mask & IN_IGNORED) {
+				changedPaths.push_back(watchedDirectory->second);
+				watchedDirectories.erase(watchedDirectory);
+				continue;
+			}
+
+			if (event->len == 0) {
+				continue;
+			}
+
+			const auto path = (fs::path(watchedDirectory->second) / event->name).string();
+			const bool isDirectory = (event->mask & IN_ISDIR) != 0;
+			if (isDirectory ? recursive : ((event->mask & IN_CREATE) == 0 && XFile::ExtensionMatches(path, ".dll"))) {
+				changedPaths.push_back(path);
+			}
+		}
+
+		timeout = settleMilliseconds;
+	}
+
+	std::sort(changedPaths.begin(), changedPaths.end());
+	changedPaths.erase(std::unique(changedPaths.begin(), changedPaths.end()), changedPaths.end());
+	return changedPaths;
+}
+
+void MissionWatcher::RemoveWatchesBelow(const std::string& directory)
+{
+	const auto directoryPrefix = GetDirectoryPrefix(directory);
+
+	for (auto it = watchedDirectories.begin(); it != watchedDirectories.end(); ) {
+		if (it->second == directory || IsBelowDirectory(it->second, directoryPrefix)) {
+			inotify_rm_watch(inotifyDescriptor, it->first);
+			it = watchedDirectories.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+#else
+
+MissionWatcher::MissionWatcher(const std::vector<std::string>&, bool)
+{
+	throw std::runtime_error("Watching for file changes requires inotify, which is only available on Linux");
+}
+
+MissionWatcher::~MissionWatcher()
+{
+}
+
+void MissionWatcher::AddWatch(const std::string&)
+{
+}
+
+void MissionWatcher::AddWatchRecursive(const std::string&)
+{
+}
+
+std::vector<std::string> MissionWatcher::ReadChangedPaths()
+{
+	return {};
+}
+
+void MissionWatcher::RemoveWatchesBelow(const std::string&)
+{
+}
+
+#endif
+
+
+void MissionWatcher::AddScannedRow(const MissionRow& row)
+{
+	if (!row.isMission) {
+		return;
+	}
+
+	// Stamp taken by the worker before parsing, as the file may have changed again since
+	if (row.fileStamp) {
+		missions[row.path] = WatchedMission{ row.filename, *row.fileStamp };
+	}
+}
+
+void MissionWatcher::Run()
+{
+	while (!watchedDirectories.empty()) {
+		const auto changedPaths = ReadChangedPaths();
+
+		if (isOverflowed) {
+			isOverflowed = false;
+			for (const auto& directory : rootDirectories) {
+				ScanDirectory(directory);
+			}
+			continue;
+		}
+
+		for (const auto& path : changedPaths) {
+			std::error_code errorCode;
+			if (fs::is_directory(fs::symlink_status(path, errorCode))) {
+				if (recursive) {
+					ScanDirectory(path);
+				}
+				continue;
+			}
+
+			// Path may have been a directory that was deleted or moved away
+			RemoveWatchesBelow(path);
+			RemoveMissionsBelow(path);
+			ScanChangedPath(path);
+		}
+	}
+}
+
+// Missing files, and files that are no longer missions, are reported as removed.
+// Files with the same size and modification time as when last scanned are not parsed again.
+void MissionWatcher::ScanChangedPath(const std::string& path)
+{
+	const auto fileStamp = GetFileStamp(path);
+	std::error_code errorCode;
+	if (!fileStamp || !fs::is_regular_file(path, errorCode)) {
+		RemoveMission(path);
+		return;
+	}
+
+	const auto mission = missions.find(path);
+	const bool isKnownMission = mission != missions.end();
+	if (isKnownMission && mission->second.fileStamp == *fileStamp) {
+		return;
+	}
+
+	const auto row = ScanMissionRow(path);
+	if (!row.openError.empty()) {
+		std::cerr << "Error opening DLL: " << row.path << " : " << row.openError << std::endl;
+		return;
+	}
+
+	if (!row.isMission) {
+		RemoveMission(path);
+		return;
+	}
+
+	WriteMissionEvent(isKnownMission ? MissionEvent::Update : MissionEvent::Add, row);
+	missions[path] = WatchedMission{ row.filename, *fileStamp };
+}
+
+// Rescans every DLL in a directory, also watching and rescanning subdirectories when recursive.
+// Used for directories created or moved in, and to recover after events were lost.
+void MissionWatcher::ScanDirectory(const std::string& directory)
+{
+	const auto directoryPrefix = GetDirectoryPrefix(directory);
+	std::vector<std::string> removedPaths;
+	for (auto it = missions.lower_bound(directoryPrefix); it != missions.end() && IsBelowDirectory(it->first, directoryPrefix); ++it) {
+		std::error_code errorCode;
+		if (!fs::exists(it->first, errorCode)) {
+			removedPaths.push_back(it->first);
+		}
+	}
+	for (const auto& path : removedPaths) {
+		RemoveMission(path);
+	}
+
+	std::vector<std::pair<std::string, bool>> entries;
+	std::error_code errorCode;
+	for (fs::directory_iterator it(directory, errorCode), end; !errorCode && it != end; it.increment(errorCode)) {
+		const auto path = it->path().string();
+		const bool isDirectory = fs::is_directory(it->symlink_status());
+		if (isDirectory ? recursive : XFile::ExtensionMatches(path, ".dll")) {
+			entries.emplace_back(path, isDirectory);
+		}
+	}
+	std::sort(entries.begin(), entries.end());
+
+	for (const auto& entry : entries) {
+		if (!entry.second) {
+			ScanChangedPath(entry.first);
+			continue;
+		}
+
+		// Watching an already watched directory keeps its existing watch
+		try {
+			AddWatch(entry.first);
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			continue;
+		}
+		ScanDirectory(entry.first);
+	}
+}
+
+void MissionWatcher::RemoveMissionsBelow(const std::string& directory)
+{
+	const auto directoryPrefix = GetDirectoryPrefix(directory);
+	while (true) {
+		const auto it = missions.lower_bound(directoryPrefix);
+		if (it == missions.end() || !IsBelowDirectory(it->first, directoryPrefix)) {
+			return;
+		}
+		RemoveMission(it->first);
+	}
+}
+
+void MissionWatcher::RemoveMission(const std::string& path)
+{
+	const auto mission = missions.find(path);
+	if (mission == missions.end()) {
+		return;
+	}
+
+	MissionRow row;
+	row.path = path;
+	row.filename = mission->second.filename;
+	WriteMissionEvent(MissionEvent::Remove, row);
+
+	missions.erase(mission);
+}
+
+
+// Trailing separator, so sibling directories sharing a name prefix are not matched
+std::string GetDirectoryPrefix(const std::string& directory)
+{
+	return (fs::path(directory) / "").string();
+}
+
+bool IsBelowDirectory(const std::string& path, const std::string& directoryPrefix)
+{
+	return path.compare(0, directoryPrefix.size(), directoryPrefix) == 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MissionRow.h"
+#include "ScanCache.h"
+#include <string>
+#include <vector>
+#include <map>
+
+
+// Rescans DLLs in watched directories as they change, writing add, update and remove events as JSON lines
+// Only directories are watched. Individual files and archives named on the command line are not.
+class MissionWatcher
+{
+public:
+	// Subdirectories are watched as well when recursive, including ones created later
+	MissionWatcher(const std::vector<std::string>& directories, bool recursive);
+	~MissionWatcher();
+
+	MissionWatcher(const MissionWatcher&) = delete;
+	MissionWatcher& operator=(const MissionWatcher&) = delete;
+
+	// Records a row written by the initial scan, so later changes are reported relative to it
+	void AddScannedRow(const MissionRow& row);
+
+	// Blocks, writing events until interrupted or no watched directories remain
+	void Run();
+
+private:
+	struct WatchedMission
+	{
+		std::string filename;
+		FileStamp fileStamp;
+	};
+
+	std::vector<std::string> rootDirectories;
+	bool recursive;
+	int inotifyDescriptor = -1;
+	bool isOverflowed = false;
+	std::map<int, std::string> watchedDirectories;
+	std::map<std::string, WatchedMission> missions;
+
+	void AddWatch(const std::string& directory);
+	void AddWatchRecursive(const std::string& directory);
+	std::vector<std::string> ReadChangedPaths();
+	void RemoveWatchesBelow(const std::string& directory);
+	void ScanChangedPath(const std::string& path);
+	void ScanDirectory(const std::string& directory);
+	void RemoveMissionsBelow(const std::string& directory);
+	void RemoveMission(const std::string& path);
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 // Pulled from Outpost2DLL project to remove formal compilation reference to the entire Outpost2DLL project
 
 
@@ -18,6 +20,22 @@ struct AIModDesc
 	int checksum;
 };
 
+// Layout of AIModDesc as stored within a 32 bit mission DLL
+// Pointers are 32 bit virtual addresses, so the layout does not depend on the scanner's own pointer size
+struct AIModDesc32
+{
+	int missionType;
+	int numPlayers;
+	int maxTechLevel;
+	int boolUnitMission;
+	std::uint32_t mapName;
+	std::uint32_t levelDesc;
+	std::uint32_t techtreeName;
+	int checksum;
+};
+
+static_assert(32 == sizeof(AIModDesc32), "AIModDesc32 is an unexpected size");
+
 
 // Mission types, and the corresponding DLL name prefix
 // Note: For campaign games, use a positive level number, and a prefix of e (Eden) or p (Plymouth)
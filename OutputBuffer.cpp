@@ -0,0 +1,112 @@
+#include "OutputBuffer.h"
+#include <array>
+#include <charconv>
+
+
+OutputBuffer::OutputBuffer(std::ostream& stream, std::size_t blockSize) :
+	stream(stream),
+	blockSize(blockSize)
+{
+	// Leave room for the line that crosses the block size, so the buffer is not reallocated
+	buffer.reserve(blockSize * 2);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+	Flush();
+}
+
+void OutputBuffer::WritePadded(std::string_view text, std::size_t width)
+{
+	buffer.append(text);
+	if (text.size() < width) {
+		buffer.append(width - text.size(), ' ');
+	}
+}
+
+void OutputBuffer::WriteInteger(int value, std::size_t width)
+{
+	std::array<char, 12> digits; // Large enough for any 32 bit int including sign
+	const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+
+	WritePadded(std::string_view(digits.data(), result.ptr - digits.data()), width);
+}
+
+void OutputBuffer::WriteInteger(std::uint32_t value, std::size_t width)
+{
+	std::array<char, 10> digits; // Large enough for any 32 bit unsigned int
+	const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+
+	WritePadded(std::string_view(digits.data(), result.ptr - digits.data()), width);
+}
+
+void OutputBuffer::WriteHex(std::uint32_t value, std::size_t digitCount)
+{
+	constexpr std::string_view hexDigits("0123456789ABCDEF");
+
+	for (std::size_t i = digitCount; i > 0; --i) {
+		buffer.push_back(hexDigits[(value >> ((i - 1) * 4)) & 0xf]);
+	}
+}
+
+void OutputBuffer::EndLine()
+{
+	buffer.push_back('\n');
+	EndRecord();
+}
+
+void OutputBuffer::EndRecord()
+{
+	if (buffer.size() >= blockSize) {
+		Flush();
+	}
+}
+
+void OutputBuffer::Flush()
+{
+	if (!buffer.empty()) {
+		stream.write(buffer.data(), buffer.size());
+		buffer.clear();
+	}
+}
+
+
+void WriteJsonString(OutputBuffer& output, std::string_view value)
+{
+	constexpr std::string_view hexDigits("0123456789abcdef");
+
+	output.Write('"');
+	for (const auto character : value) {
+		const auto byte = static_cast<unsigned char>(character);
+		if (byte == '"' || byte == '\\') {
+			output.Write('\\');
+			output.Write(character);
+		}
+		else if (byte < 0x20 || byte >= 0x7f) {
+			output.Write("\\u00");
+			output.Write(hexDigits[byte >> 4]);
+			output.Write(hexDigits[byte & 0xf]);
+		}
+		else {
+			output.Write(character);
+		}
+	}
+	output.Write('"');
+}
+
+void WriteCsvField(OutputBuffer& output, std::string_view value)
+{
+	if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+		output.Write(value);
+		return;
+	}
+
+	output.Write('"');
+	for (const auto character : value) {
+		if (character == '"') {
+			output.Write('"');
+		}
+		output.Write(character);
+	}
+	output.Write('"');
+}
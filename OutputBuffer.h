@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+
+// Accumulates formatted output in a reusable buffer, handing it to the stream in large blocks.
+// The stream is never explicitly flushed, so output piped to another process is not flushed per line.
+class OutputBuffer
+{
+public:
+	explicit OutputBuffer(std::ostream& stream, std::size_t blockSize = 64 * 1024);
+	~OutputBuffer();
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	void Write(std::string_view text) { buffer.append(text); }
+	void Write(char character) { buffer.push_back(character); }
+
+	// Left aligned and padded with spaces to the width. Longer text is not truncated.
+	void WritePadded(std::string_view text, std::size_t width);
+	void WriteInteger(int value, std::size_t width = 0);
+	void WriteInteger(std::uint32_t value, std::size_t width = 0);
+
+	// Upper case and zero padded to the digit count of at most 8, without a prefix
+	void WriteHex(std::uint32_t value, std::size_t digitCount);
+
+	// Ends a line of text output
+	void EndLine();
+
+	// Hands the buffer to the stream once a full block has accumulated
+	void EndRecord();
+
+	// Hands any buffered output to the stream.
+	// Call before writing to another stream sharing the console, such as std::cerr, to preserve ordering.
+	void Flush();
+
+private:
+	std::ostream& stream;
+	std::string buffer;
+	std::size_t blockSize;
+};
+
+// Quoted JSON string. Outpost 2 strings are single byte encoded, so bytes outside ASCII are escaped
+// as the matching Latin-1 code point, and the output is always valid UTF-8.
+void WriteJsonString(OutputBuffer& output, std::string_view value);
+
+// RFC 4180 field. Fields containing separators, quotes or line breaks are quoted, with quotes doubled.
+void WriteCsvField(OutputBuffer& output, std::string_view value);
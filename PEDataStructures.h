@@ -77,6 +77,47 @@ struct Image32Bit
 static_assert(96 == sizeof(Image32Bit), "Image32Bit is an unexpected size");
 
 
+// PE32+ optional header, used by 64 bit images. Image base and memory sizes widen to 64 bits, and baseOfData is removed.
+struct Image64Bit
+{
+	std::uint16_t magic;
+	std::uint8_t majorLinkerVersion;
+	std::uint8_t minorLinkerVersion;
+	std::uint32_t sizeOfCode;
+	std::uint32_t sizeOfInitializedData;
+	std::uint32_t sizeOfUninitializedData;
+	std::uint32_t addressOfEntryPoint;
+	std::uint32_t baseOfCode;
+	std::uint64_t imageBase;
+	std::uint32_t sectionAlignment;
+	std::uint32_t fileAlignment;
+	std::uint16_t majorOperatingSystemVersion;
+	std::uint16_t minorOperatingSystemVersion;
+	std::uint16_t majorImageVersion;
+	std::uint16_t minorImageVersion;
+	std::uint16_t majorSubsystemVersion;
+	std::uint16_t minorSubsystemVersion;
+	std::uint32_t win32VersionValue;
+	std::uint32_t sizeOfImage;
+	std::uint32_t sizeOfHeaders;
+	std::uint32_t checkSum;
+	std::uint16_t subsystem;
+	std::uint16_t dllCharacteristics;
+	std::uint64_t sizeOfStackReserve;
+	std::uint64_t sizeOfStackCommit;
+	std::uint64_t sizeOfHeapReserve;
+	std::uint64_t sizeOfHeapCommit;
+	std::uint32_t loaderFlags;
+	std::uint32_t numberOfRvaAndSizes;
+};
+
+static_assert(112 == sizeof(Image64Bit), "Image64Bit is an unexpected size");
+
+// Optional header magic numbers, identifying the layout that follows
+constexpr std::uint16_t image32BitMagic = 0x10b;
+constexpr std::uint16_t image64BitMagic = 0x20b;
+
+
 struct SectionTable
 {
 	char name[8];
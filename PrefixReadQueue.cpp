@@ -0,0 +1,295 @@
+#include "PrefixReadQueue.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef __linux__
+
+// Low bits of each operation's user data, above which is the slot index
+enum class RingOperation : std::uint64_t
+{
+	Open,
+	Read,
+	ReadAhead,
+	Close,
+};
+
+constexpr std::uint64_t ringOperationBits = 2;
+
+std::uint64_t MakeUserData(std::size_t slotIndex, RingOperation ringOperation);
+
+
+PrefixReadQueue::PrefixReadQueue(std::size_t queueDepth, std::size_t prefixSize, ReadAheadPredicate shouldReadAhead) :
+	prefixSize(prefixSize),
+	shouldReadAhead(std::move(shouldReadAhead)),
+	slots(std::max<std::size_t>(queueDepth, 1)),
+	freeSlotCount(slots.size())
+{
+	// Each slot has at most two operations outstanding, a read ahead linked to a close,
+	// so neither ring fills and completions are never dropped
+	io_uring_params parameters{};
+	ringDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(slots.size() * 2), &parameters));
+	if (ringDescriptor < 0) {
+		throw std::runtime_error("Unable to set up io_uring : " + std::string(std::strerror(errno)));
+	}
+
+	// Opening, reading and closing files arrived in Linux 5.6 along with IORING_FEAT_RW_CUR_POS.
+	// Both rings then share one mapping.
+	constexpr std::uint32_t requiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_RW_CUR_POS;
+	if ((parameters.features & requiredFeatures) != requiredFeatures) {
+		close(ringDescriptor);
+		throw std::runtime_error("io_uring on this kernel can not open and read files");
+	}
+
+	ringMemorySize = std::max(parameters.sq_off.array + parameters.sq_entries * sizeof(std::uint32_t),
+		parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe));
+	ringMemory = mmap(nullptr, ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING);
+
+	submissionEntriesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+	void* entries = mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES);
+
+	if (ringMemory == MAP_FAILED || entries == MAP_FAILED) {
+		const auto mapError = errno;
+		ringMemory = ringMemory == MAP_FAILED ? nullptr : ringMemory;
+		submissionEntries = entries == MAP_FAILED ? nullptr : static_cast<io_uring_sqe*>(entries);
+		Unmap();
+		close(ringDescriptor);
+		throw std::runtime_error("Unable to map io_uring : " + std::string(std::strerror(mapError)));
+	}
+
+	auto* ring = static_cast<char*>(ringMemory);
+	submissionEntries = static_cast<io_uring_sqe*>(entries);
+	submissionTail = reinterpret_cast<std::uint32_t*>(ring + parameters.sq_off.tail);
+	submissionMask = *reinterpret_cast<const std::uint32_t*>(ring + parameters.sq_off.ring_mask);
+	submissionArray = reinterpret_cast<std::uint32_t*>(ring + parameters.sq_off.array);
+	completionHead = reinterpret_cast<std::uint32_t*>(ring + parameters.cq_off.head);
+	completionTail = reinterpret_cast<const std::uint32_t*>(ring + parameters.cq_off.tail);
+	completionMask = *reinterpret_cast<const std::uint32_t*>(ring + parameters.cq_off.ring_mask);
+	completionEntries = reinterpret_cast<const io_uring_cqe*>(ring + parameters.cq_off.cqes);
+}
+
+PrefixReadQueue::~PrefixReadQueue()
+{
+	try {
+		while (!IsIdle()) {
+			WaitForCompletions();
+		}
+	}
+	catch (const std::exception&) {
+		// Closing the ring cancels whatever is still in flight
+	}
+
+	Unmap();
+	close(ringDescriptor);
+}
+
+void PrefixReadQueue::Submit(std::uint64_t tag, const std::string& path)
+{
+	const auto slot = std::find_if(slots.begin(), slots.end(), [](const Slot& slot) {
+		return slot.state == SlotState::Free;
+	});
+	if (slot == slots.end()) {
+		throw std::logic_error("No free slot to submit a prefix read");
+	}
+
+	slot->state = SlotState::Opening;
+	slot->tag = tag;
+	slot->path = path;
+	--freeSlotCount;
+
+	auto* entry = GetSubmissionEntry();
+	entry->opcode = IORING_OP_OPENAT;
+	entry->fd = AT_FDCWD;
+	entry->addr = reinterpret_cast<std::uint64_t>(slot->path.c_str());
+	entry->open_flags = O_RDONLY | O_CLOEXEC;
+	entry->user_data = MakeUserData(slot - slots.begin(), RingOperation::Open);
+}
+
+std::vector<PrefixReadQueue::CompletedRead> PrefixReadQueue::WaitForCompletions()
+{
+	Enter(1);
+
+	std::vector<CompletedRead> completedReads;
+	auto head = *completionHead;
+	const auto tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head) {
+		const auto& entry = completionEntries[head & completionMask];
+		CompleteOperation(entry.user_data, entry.res, completedReads);
+	}
+	__atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+
+	return completedReads;
+}
+
+void PrefixReadQueue::CompleteOperation(std::uint64_t userData, std::int32_t result, std::vector<CompletedRead>& completedReads)
+{
+	const auto slotIndex = static_cast<std::size_t>(userData >> ringOperationBits);
+	auto& slot = slots[slotIndex];
+
+	switch (static_cast<RingOperation>(userData & ((1 << ringOperationBits) - 1)))
+	{
+	case RingOperation::Open:
+		if (result < 0) {
+			completedReads.push_back(CompletedRead{ slot.tag, std::nullopt });
+			slot.state = SlotState::Free;
+			++freeSlotCount;
+			return;
+		}
+		slot.fileDescriptor = result;
+		slot.bytesRead = 0;
+		slot.prefix.resize(prefixSize);
+		SubmitRead(slotIndex);
+		return;
+	case RingOperation::Read:
+		if (result < 0) {
+			completedReads.push_back(CompletedRead{ slot.tag, std::nullopt });
+			SubmitClose(slotIndex, false);
+			return;
+		}
+		// Network filesystems may return less than requested before the end of the file, so read on until the prefix is full or the file ends
+		slot.bytesRead += static_cast<std::size_t>(result);
+		if (result > 0 && slot.bytesRead < prefixSize) {
+			SubmitRead(slotIndex);
+			return;
+		}
+		{
+			slot.prefix.resize(slot.bytesRead);
+			const bool readAhead = slot.prefix.size() == prefixSize && shouldReadAhead && shouldReadAhead(slot.prefix);
+			completedReads.push_back(CompletedRead{ slot.tag, std::move(slot.prefix) });
+			SubmitClose(slotIndex, readAhead);
+		}
+		return;
+	case RingOperation::ReadAhead:
+		// Advice only. The linked close frees the slot whether or not it succeeded.
+		return;
+	case RingOperation::Close:
+		slot.state = SlotState::Free;
+		slot.fileDescriptor = -1;
+		++freeSlotCount;
+		return;
+	}
+}
+
+void PrefixReadQueue::SubmitRead(std::size_t slotIndex)
+{
+	auto& slot = slots[slotIndex];
+	slot.state = SlotState::Reading;
+
+	// Continues from the end of any earlier short read
+	auto* entry = GetSubmissionEntry();
+	entry->opcode = IORING_OP_READ;
+	entry->fd = slot.fileDescriptor;
+	entry->addr = reinterpret_cast<std::uint64_t>(slot.prefix.data() + slot.bytesRead);
+	entry->len = static_cast<std::uint32_t>(prefixSize - slot.bytesRead);
+	entry->off = slot.bytesRead;
+	entry->user_data = MakeUserData(slotIndex, RingOperation::Read);
+}
+
+// Read ahead covers the whole file. A hard link runs the close even if the advice fails.
+void PrefixReadQueue::SubmitClose(std::size_t slotIndex, bool readAhead)
+{
+	auto& slot = slots[slotIndex];
+	slot.state = SlotState::Closing;
+
+	if (readAhead) {
+		auto* entry = GetSubmissionEntry();
+		entry->opcode = IORING_OP_FADVISE;
+		entry->fd = slot.fileDescriptor;
+		entry->off = 0;
+		entry->len = 0;
+		entry->fadvise_advice = POSIX_FADV_WILLNEED;
+		entry->flags = IOSQE_IO_HARDLINK;
+		entry->user_data = MakeUserData(slotIndex, RingOperation::ReadAhead);
+	}
+
+	auto* entry = GetSubmissionEntry();
+	entry->opcode = IORING_OP_CLOSE;
+	entry->fd = slot.fileDescriptor;
+	entry->user_data = MakeUserData(slotIndex, RingOperation::Close);
+}
+
+io_uring_sqe* PrefixReadQueue::GetSubmissionEntry()
+{
+	const auto index = (*submissionTail + unsubmittedCount) & submissionMask;
+	++unsubmittedCount;
+
+	auto* entry = &submissionEntries[index];
+	std::memset(entry, 0, sizeof(*entry));
+	submissionArray[index] = index;
+	return entry;
+}
+
+// Publishes entries written since the last call, then waits for the minimum number of completions
+void PrefixReadQueue::Enter(std::uint32_t minimumCompletions)
+{
+	__atomic_store_n(submissionTail, *submissionTail + unsubmittedCount, __ATOMIC_RELEASE);
+
+	while (true) {
+		const auto result = syscall(__NR_io_uring_enter, ringDescriptor, unsubmittedCount, minimumCompletions, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error("Unable to submit io_uring reads : " + std::string(std::strerror(errno)));
+		}
+
+		unsubmittedCount -= static_cast<std::uint32_t>(result);
+		if (unsubmittedCount == 0) {
+			return;
+		}
+	}
+}
+
+void PrefixReadQueue::Unmap()
+{
+	if (submissionEntries != nullptr) {
+		munmap(submissionEntries, submissionEntriesSize);
+	}
+	if (ringMemory != nullptr) {
+		munmap(ringMemory, ringMemorySize);
+	}
+	submissionEntries = nullptr;
+	ringMemory = nullptr;
+}
+
+
+std::uint64_t MakeUserData(std::size_t slotIndex, RingOperation ringOperation)
+{
+	return (static_cast<std::uint64_t>(slotIndex) << ringOperationBits) | static_cast<std::uint64_t>(ringOperation);
+}
+
+#else
+
+PrefixReadQueue::PrefixReadQueue(std::size_t queueDepth, std::size_t prefixSize, ReadAheadPredicate shouldReadAhead) :
+	prefixSize(prefixSize),
+	shouldReadAhead(std::move(shouldReadAhead)),
+	slots(std::max<std::size_t>(queueDepth, 1)),
+	freeSlotCount(slots.size())
+{
+	throw std::runtime_error("io_uring is only available on Linux");
+}
+
+PrefixReadQueue::~PrefixReadQueue()
+{
+}
+
+void PrefixReadQueue::Submit(std::uint64_t, const std::string&)
+{
+}
+
+std::vector<PrefixReadQueue::CompletedRead> PrefixReadQueue::WaitForCompletions()
+{
+	return {};
+}
+
+#endif
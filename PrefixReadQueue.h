@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Reads the start of many files with the reads in flight together, using io_uring on Linux.
+// A scan of a cold page cache or network filesystem then waits on round trips in batches instead of one file at a time.
+// Only the submitting thread may use the queue.
+class PrefixReadQueue
+{
+public:
+	struct CompletedRead
+	{
+		std::uint64_t tag;
+
+		// Empty if the file could not be opened or read
+		std::optional<std::string> prefix;
+	};
+
+	// Called with each prefix read. Returning true asks the kernel to read the rest of the file ahead,
+	// so the reads of a parser mapping the whole file are already in flight.
+	using ReadAheadPredicate = std::function<bool(std::string_view prefix)>;
+
+	// Throws if io_uring is unavailable, such as on older kernels, in sandboxes that block it, or on other platforms
+	PrefixReadQueue(std::size_t queueDepth, std::size_t prefixSize, ReadAheadPredicate shouldReadAhead);
+
+	// Waits for any operations still in flight, as the kernel writes into the queue's buffers
+	~PrefixReadQueue();
+
+	PrefixReadQueue(const PrefixReadQueue&) = delete;
+	PrefixReadQueue& operator=(const PrefixReadQueue&) = delete;
+
+	// Number of files that may be submitted before a slot frees up
+	std::size_t FreeSlotCount() const { return freeSlotCount; }
+	bool IsIdle() const { return freeSlotCount == slots.size(); }
+
+	// Starts reading the file's prefix. Requires a free slot.
+	void Submit(std::uint64_t tag, const std::string& path);
+
+	// Waits until at least one operation completes, returning any reads finished.
+	// May return no reads when only closing files completed. Must not be called while idle.
+	std::vector<CompletedRead> WaitForCompletions();
+
+private:
+	enum class SlotState
+	{
+		Free,
+		Opening,
+		Reading,
+		Closing,
+	};
+
+	struct Slot
+	{
+		SlotState state = SlotState::Free;
+		std::uint64_t tag = 0;
+		std::string path;
+		std::string prefix;
+		std::size_t bytesRead = 0;
+		int fileDescriptor = -1;
+	};
+
+	std::size_t prefixSize;
+	ReadAheadPredicate shouldReadAhead;
+	std::vector<Slot> slots;
+	std::size_t freeSlotCount;
+
+	int ringDescriptor = -1;
+	void* ringMemory = nullptr;
+	std::size_t ringMemorySize = 0;
+	io_uring_sqe* submissionEntries = nullptr;
+	std::size_t submissionEntriesSize = 0;
+
+	// Pointers into the shared ring memory
+	std::uint32_t* submissionTail = nullptr;
+	std::uint32_t submissionMask = 0;
+	std::uint32_t* submissionArray = nullptr;
+	std::uint32_t* completionHead = nullptr;
+	const std::uint32_t* completionTail = nullptr;
+	std::uint32_t completionMask = 0;
+	const io_uring_cqe* completionEntries = nullptr;
+
+	// Entries written since the last io_uring_enter. The tail is only published to the kernel on entering.
+	std::uint32_t unsubmittedCount = 0;
+
+	io_uring_sqe* GetSubmissionEntry();
+	void SubmitRead(std::size_t slotIndex);
+	void SubmitClose(std::size_t slotIndex, bool readAhead);
+	void Enter(std::uint32_t minimumCompletions);
+	void CompleteOperation(std::uint64_t userData, std::int32_t result, std::vector<CompletedRead>& completedReads);
+	void Unmap();
+};
@@ -0,0 +1,233 @@
+#include "ScanCache.h"
+#include "MissionArchive.h"
+#include "BinaryStream.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <array>
+#include <algorithm>
+#include <system_error>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+// Bump version whenever the entry layout changes, so stale caches are discarded rather than misread
+constexpr std::array<char, 8> cacheSignature{ 'M', 'S', 'C', 'A', 'C', 'H', 'E', '3' };
+
+enum RowFlags : std::uint8_t
+{
+	IsMission = 1 << 0,
+	HasAIModDesc = 1 << 1,
+	HasMapName = 1 << 2,
+	HasTechtreeName = 1 << 3,
+	HasLevelDesc = 1 << 4,
+	HasContentDigest = 1 << 5,
+};
+
+
+std::optional<FileStamp> GetFileStamp(const std::string& path)
+{
+	// Entries inside an archive only change when the archive itself changes
+	const auto archivedPath = SplitArchivedPath(path);
+	const auto& stampedPath = archivedPath ? archivedPath->archivePath : path;
+
+	std::error_code errorCode;
+
+	const auto size = fs::file_size(stampedPath, errorCode);
+	if (errorCode) {
+		return std::nullopt;
+	}
+
+	const auto modifiedTime = fs::last_write_time(stampedPath, errorCode);
+	if (errorCode) {
+		return std::nullopt;
+	}
+
+	return FileStamp{ size, static_cast<std::int64_t>(modifiedTime.time_since_epoch().count()) };
+}
+
+
+ScanCache::ScanCache(const std::string& filename) :
+	filename(filename)
+{
+	try {
+		Load();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Ignoring unreadable scan cache " << filename << " : " << e.what() << std::endl;
+		entries.clear();
+	}
+}
+
+std::optional<MissionRow> ScanCache::Find(const std::string& path, const FileStamp& fileStamp)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const auto entry = entries.find(path);
+	if (entry == entries.end() || !(entry->second.fileStamp == fileStamp)) {
+		return std::nullopt;
+	}
+
+	entry->second.isSeen = true;
+	return entry->second.row;
+}
+
+void ScanCache::Store(const MissionRow& row, const FileStamp& fileStamp)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	entries[row.path] = Entry{ fileStamp, row, true };
+	isModified = true;
+}
+
+void ScanCache::Load()
+{
+	std::ifstream stream(filename, std::ios::binary);
+	if (!stream) {
+		return;
+	}
+	stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+	if (ReadValue<std::array<char, 8>>(stream) != cacheSignature) {
+		throw std::runtime_error("Unrecognized cache signature or version");
+	}
+
+	const auto entryCount = ReadValue<std::uint64_t>(stream);
+	for (std::uint64_t i = 0; i < entryCount; ++i) {
+		FileStamp fileStamp;
+		auto row = ReadCacheEntry(stream, fileStamp);
+		auto path = row.path;
+		entries.insert_or_assign(std::move(path), Entry{ fileStamp, std::move(row) });
+	}
+}
+
+void ScanCache::Save(bool isScanComplete) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const auto isKept = [isScanComplete](const Entry& entry) {
+		return entry.isSeen || !isScanComplete;
+	};
+	const auto keptCount = static_cast<std::uint64_t>(std::count_if(entries.begin(), entries.end(), [&isKept](const auto& entry) {
+		return isKept(entry.second);
+	}));
+
+	if (!isModified && keptCount == entries.size()) {
+		return;
+	}
+
+	// Write to a temporary file first, so an interrupted save never leaves a truncated cache behind
+	const auto temporaryFilename = filename + ".tmp";
+	{
+		std::ofstream stream(temporaryFilename, std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			throw std::runtime_error("Unable to write scan cache : " + temporaryFilename);
+		}
+		stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+		WriteValue(stream, cacheSignature);
+		WriteValue(stream, keptCount);
+		for (const auto& entry : entries) {
+			if (isKept(entry.second)) {
+				WriteCacheEntry(stream, entry.second.row, entry.second.fileStamp);
+			}
+		}
+	}
+
+	fs::rename(temporaryFilename, filename);
+}
+
+
+void WriteCacheEntry(std::ostream& stream, const MissionRow& row, const FileStamp& fileStamp)
+{
+	std::uint8_t flags = 0;
+	flags |= row.isMission ? IsMission : 0;
+	flags |= row.aiModDesc ? HasAIModDesc : 0;
+	flags |= row.mapName ? HasMapName : 0;
+	flags |= row.techtreeName ? HasTechtreeName : 0;
+	flags |= row.levelDesc ? HasLevelDesc : 0;
+	flags |= row.contentDigest ? HasContentDigest : 0;
+
+	WriteString(stream, row.path);
+	WriteValue(stream, fileStamp.size);
+	WriteValue(stream, fileStamp.modifiedTime);
+	// Row content restored on a hit, for binary output and ScanMissions callers. Validity is decided by the FileStamp alone.
+	WriteValue(stream, row.timeDateStamp);
+	WriteValue(stream, flags);
+	WriteString(stream, row.filename);
+	WriteString(stream, row.openError);
+	WriteString(stream, row.readError);
+
+	// Pointer fields of AIModDesc32 refer to the DLL's address space, and are not persisted
+	if (row.aiModDesc) {
+		WriteValue(stream, row.aiModDesc->missionType);
+		WriteValue(stream, row.aiModDesc->numPlayers);
+		WriteValue(stream, row.aiModDesc->maxTechLevel);
+		WriteValue(stream, row.aiModDesc->boolUnitMission);
+		WriteValue(stream, row.aiModDesc->checksum);
+	}
+	if (row.mapName) {
+		WriteString(stream, *row.mapName);
+	}
+	if (row.techtreeName) {
+		WriteString(stream, *row.techtreeName);
+	}
+	if (row.levelDesc) {
+		WriteString(stream, *row.levelDesc);
+	}
+	if (row.contentDigest) {
+		WriteValue(stream, row.contentDigest->size);
+		WriteValue(stream, row.contentDigest->hash);
+		WriteValue(stream, row.contentDigest->checkHash);
+	}
+}
+
+MissionRow ReadCacheEntry(std::istream& stream, FileStamp& fileStamp)
+{
+	MissionRow row;
+
+	row.path = ReadString(stream);
+	fileStamp.size = ReadValue<std::uint64_t>(stream);
+	fileStamp.modifiedTime = ReadValue<std::int64_t>(stream);
+	row.timeDateStamp = ReadValue<std::uint32_t>(stream);
+	const auto flags = ReadValue<std::uint8_t>(stream);
+	row.filename = ReadString(stream);
+	row.openError = ReadString(stream);
+	row.readError = ReadString(stream);
+
+	row.isMission = (flags & IsMission) != 0;
+	if (flags & HasAIModDesc) {
+		AIModDesc32 aiModDesc{};
+		aiModDesc.missionType = ReadValue<int>(stream);
+		aiModDesc.numPlayers = ReadValue<int>(stream);
+		aiModDesc.maxTechLevel = ReadValue<int>(stream);
+		aiModDesc.boolUnitMission = ReadValue<int>(stream);
+		aiModDesc.checksum = ReadValue<int>(stream);
+		row.aiModDesc = aiModDesc;
+	}
+	if (flags & HasMapName) {
+		row.mapName = ReadString(stream);
+	}
+	if (flags & HasTechtreeName) {
+		row.techtreeName = ReadString(stream);
+	}
+	if (flags & HasLevelDesc) {
+		row.levelDesc = ReadString(stream);
+	}
+	if (flags & HasContentDigest) {
+		ContentDigest contentDigest{};
+		contentDigest.size = ReadValue<std::uint64_t>(stream);
+		contentDigest.hash = ReadValue<std::uint64_t>(stream);
+		contentDigest.checkHash = ReadValue<std::uint64_t>(stream);
+		row.contentDigest = contentDigest;
+	}
+
+	return row;
+}
+
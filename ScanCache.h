@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MissionRow.h"
+#include <string>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+
+
+// Returns nullopt if the file can not be inspected
+std::optional<FileStamp> GetFileStamp(const std::string& path);
+
+// Layout of each cache file entry, also used for the run files of sorts spilled to disk.
+// duplicateOf is not stored.
+void WriteCacheEntry(std::ostream& stream, const MissionRow& row, const FileStamp& fileStamp);
+MissionRow ReadCacheEntry(std::istream& stream, FileStamp& fileStamp);
+
+
+// Parsed mission rows persisted between runs, keyed by path and invalidated by FileStamp
+// Safe to query and update from multiple worker threads
+class ScanCache
+{
+public:
+	// Loads existing entries. A missing or unreadable cache file starts an empty cache.
+	explicit ScanCache(const std::string& filename);
+
+	// Entries found or stored are kept by the next Save
+	std::optional<MissionRow> Find(const std::string& path, const FileStamp& fileStamp);
+	void Store(const MissionRow& row, const FileStamp& fileStamp);
+
+	// Writes entries back to disk if any changed since loading.
+	// After a complete scan, entries not found or stored are dropped, so renamed and deleted DLLs do not accumulate.
+	void Save(bool isScanComplete) const;
+
+private:
+	struct Entry
+	{
+		FileStamp fileStamp;
+		MissionRow row;
+		bool isSeen = false;
+	};
+
+	std::string filename;
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, Entry> entries;
+	bool isModified = false;
+
+	void Load();
+};
@@ -0,0 +1,176 @@
+#include "ScanStats.h"
+#include <algorithm>
+#include <iomanip>
+
+
+double ToSeconds(ScanStats::Clock::duration duration);
+double ToMilliseconds(ScanStats::Clock::duration duration);
+double ToMicroseconds(ScanStats::Clock::duration duration);
+double ToKibibytes(std::uint64_t byteCount);
+
+
+ScanStats::ScanStats() :
+	startTime(Clock::now())
+{
+}
+
+void ScanStats::AddFindPathsTime(Clock::duration duration)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	totals.findPathsTime += duration;
+}
+
+void ScanStats::AddWriteOutputTime(Clock::duration duration)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	totals.writeOutputTime += duration;
+}
+
+void ScanStats::AddFile(const MissionRow& row, const FileScanStats& fileStats)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	++totals.fileCount;
+	if (!row.openError.empty()) {
+		++totals.failedCount;
+	}
+	else if (fileStats.isRejectedByProbe) {
+		++totals.rejectedCount;
+	}
+	else if (!row.isMission) {
+		++totals.skippedCount;
+	}
+	else {
+		++totals.missionCount;
+		if (row.isFilteredOut) {
+			++totals.filteredCount;
+		}
+		else if (!row.readError.empty()) {
+			++totals.incompleteCount;
+		}
+	}
+
+	if (fileStats.isCacheHit) {
+		++totals.cacheHitCount;
+	}
+	if (fileStats.isDeduplicated) {
+		++totals.deduplicatedCount;
+	}
+
+	totals.imageReads += fileStats.imageReads;
+	totals.openTime += fileStats.openTime;
+	totals.readExportsTime += fileStats.readExportsTime;
+
+	fileLatencies.push_back(fileStats.latency);
+}
+
+void ScanStats::WriteSummary(std::ostream& stream) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto latency = GetLatencyMicroseconds();
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+
+	stream << std::endl;
+	stream << "Scan statistics" << std::endl;
+	stream << "  Files: " << totals.fileCount << " scanned, " << totals.missionCount << " missions, ";
+	stream << totals.rejectedCount << " rejected by header probe, " << totals.skippedCount << " skipped (no LevelDesc), ";
+	stream << totals.failedCount << " failed, ";
+	stream << totals.incompleteCount << " incomplete, " << totals.cacheHitCount << " cache hits, ";
+	stream << totals.deduplicatedCount << " deduplicated, " << totals.filteredCount << " filtered out" << std::endl;
+
+	stream << std::fixed << std::setprecision(1);
+	stream << "  Reads: " << ToKibibytes(totals.imageReads.imageSize) << " KiB of DLL images, ";
+	stream << ToKibibytes(totals.imageReads.bytesRead) << " KiB read, ";
+	stream << totals.imageReads.readCount << " reads, " << totals.imageReads.seekCount << " seeks" << std::endl;
+
+	stream << std::setprecision(3);
+	stream << "  Time (ms): " << ToMilliseconds(Clock::now() - startTime) << " wall, ";
+	stream << ToMilliseconds(totals.findPathsTime) << " finding paths, ";
+	stream << ToMilliseconds(totals.openTime) << " opening DLLs, ";
+	stream << ToMilliseconds(totals.readExportsTime) << " reading exports, ";
+	stream << ToMilliseconds(totals.writeOutputTime) << " writing output" << std::endl;
+
+	stream << std::setprecision(1);
+	stream << "  Latency per file (us): " << latency.p50 << " p50, " << latency.p99 << " p99, " << latency.max << " max" << std::endl;
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+void ScanStats::WriteJson(std::ostream& stream) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto latency = GetLatencyMicroseconds();
+
+	stream << "{";
+	stream << "\"files\":{";
+	stream << "\"scanned\":" << totals.fileCount;
+	stream << ",\"missions\":" << totals.missionCount;
+	stream << ",\"rejected\":" << totals.rejectedCount;
+	stream << ",\"skipped\":" << totals.skippedCount;
+	stream << ",\"failed\":" << totals.failedCount;
+	stream << ",\"incomplete\":" << totals.incompleteCount;
+	stream << ",\"cacheHits\":" << totals.cacheHitCount;
+	stream << ",\"deduplicated\":" << totals.deduplicatedCount;
+	stream << ",\"filtered\":" << totals.filteredCount;
+	stream << "},\"reads\":{";
+	stream << "\"imageBytes\":" << totals.imageReads.imageSize;
+	stream << ",\"bytesRead\":" << totals.imageReads.bytesRead;
+	stream << ",\"readCount\":" << totals.imageReads.readCount;
+	stream << ",\"seekCount\":" << totals.imageReads.seekCount;
+	stream << "},\"seconds\":{";
+	stream << "\"wall\":" << ToSeconds(Clock::now() - startTime);
+	stream << ",\"findPaths\":" << ToSeconds(totals.findPathsTime);
+	stream << ",\"openDll\":" << ToSeconds(totals.openTime);
+	stream << ",\"readExports\":" << ToSeconds(totals.readExportsTime);
+	stream << ",\"writeOutput\":" << ToSeconds(totals.writeOutputTime);
+	stream << "},\"latencyMicroseconds\":{";
+	stream << "\"p50\":" << latency.p50;
+	stream << ",\"p99\":" << latency.p99;
+	stream << ",\"max\":" << latency.max;
+	stream << "}}" << std::endl;
+}
+
+// Nearest rank percentiles
+ScanStats::Latencies ScanStats::GetLatencyMicroseconds() const
+{
+	Latencies latencies;
+	if (fileLatencies.empty()) {
+		return latencies;
+	}
+
+	auto sortedLatencies = fileLatencies;
+	std::sort(sortedLatencies.begin(), sortedLatencies.end());
+
+	const auto percentile = [&sortedLatencies](std::size_t percent) {
+		const auto rank = (sortedLatencies.size() * percent + 99) / 100;
+		return ToMicroseconds(sortedLatencies[std::max<std::size_t>(rank, 1) - 1]);
+	};
+
+	latencies.p50 = percentile(50);
+	latencies.p99 = percentile(99);
+	latencies.max = ToMicroseconds(sortedLatencies.back());
+	return latencies;
+}
+
+
+double ToSeconds(ScanStats::Clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+double ToMilliseconds(ScanStats::Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+double ToMicroseconds(ScanStats::Clock::duration duration)
+{
+	return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+double ToKibibytes(std::uint64_t byteCount)
+{
+	return byteCount / 1024.0;
+}
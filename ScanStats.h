@@ -0,0 +1,85 @@
+#pragma once
+
+#include "DllExportReader32.h"
+#include "MissionRow.h"
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+
+// Timings and image reads gathered while scanning a single DLL
+struct FileScanStats
+{
+	std::chrono::steady_clock::duration openTime{};
+	std::chrono::steady_clock::duration readExportsTime{};
+
+	// Total time to produce the row, including any cache lookup
+	std::chrono::steady_clock::duration latency{};
+
+	ImageReadCounters imageReads;
+	bool isCacheHit = false;
+
+	// Headers showed no export table, so the DLL was not opened
+	bool isRejectedByProbe = false;
+
+	// Row was copied from an earlier DLL with identical content, rather than parsed
+	bool isDeduplicated = false;
+};
+
+// Counters and per phase timers for a scan (--stats)
+// Safe to update from multiple worker threads. Phases run by workers are summed across workers.
+class ScanStats
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Wall time is measured from construction until the summary is written
+	ScanStats();
+
+	// Time spent searching for DLLs, recorded by whoever runs the search
+	void AddFindPathsTime(Clock::duration duration);
+	void AddWriteOutputTime(Clock::duration duration);
+	void AddFile(const MissionRow& row, const FileScanStats& fileStats);
+
+	// Human readable summary, intended for std::cerr
+	void WriteSummary(std::ostream& stream) const;
+
+	// Single JSON object for metrics collection
+	void WriteJson(std::ostream& stream) const;
+
+private:
+	struct Totals
+	{
+		std::uint64_t fileCount = 0;
+		std::uint64_t missionCount = 0;
+		std::uint64_t skippedCount = 0;
+		std::uint64_t rejectedCount = 0;
+		std::uint64_t failedCount = 0;
+		std::uint64_t incompleteCount = 0;
+		std::uint64_t cacheHitCount = 0;
+		std::uint64_t deduplicatedCount = 0;
+		std::uint64_t filteredCount = 0;
+		ImageReadCounters imageReads;
+		Clock::duration findPathsTime{};
+		Clock::duration openTime{};
+		Clock::duration readExportsTime{};
+		Clock::duration writeOutputTime{};
+	};
+
+	struct Latencies
+	{
+		double p50 = 0;
+		double p99 = 0;
+		double max = 0;
+	};
+
+	Clock::time_point startTime;
+	mutable std::mutex mutex;
+	Totals totals;
+	std::vector<Clock::duration> fileLatencies;
+
+	Latencies GetLatencyMicroseconds() const;
+};
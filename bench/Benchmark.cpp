@@ -0,0 +1,302 @@
+#include "SyntheticMissionDll.h"
+#include "ProcessCounters.h"
+#include "../DllExportReader32.h"
+#include "../MissionTable.h"
+#include "../Outpost2DllExportedDefinitions.h"
+#include <iostream>
+#include <iomanip>
+#include <streambuf>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+
+// Measures DllExportReader32 and WriteTable against a generated corpus of synthetic mission DLLs.
+// Usage: missionScannerBench corpusDirectory [maxCorpusSize] [paddingSectionCount] [fillerExportCount]
+//
+// Corpus sizes grow by factors of 10 from 10 DLLs up to maxCorpusSize, each a prefix of the largest corpus.
+// Files are read from a warm page cache, since they were just written.
+
+using Clock = std::chrono::steady_clock;
+
+struct PhaseResult
+{
+	std::size_t fileCount = 0;
+	Clock::duration duration{};
+	ProcessCounters counters;
+
+	void Add(const PhaseResult& other);
+};
+
+// Discards table output, so only scanning and formatting is measured
+class NullStreamBuffer : public std::streambuf
+{
+protected:
+	int_type overflow(int_type character) override { return traits_type::not_eof(character); }
+	std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+std::size_t ParseCount(const std::vector<std::string>& arguments, std::size_t index, std::size_t defaultValue);
+std::vector<std::string> GenerateCorpus(const fs::path& directory, std::size_t count, const SyntheticMissionDllOptions& baseOptions);
+void MeasureReader(const std::vector<std::string>& paths, PhaseResult& construction, PhaseResult& lookup);
+PhaseResult MeasureReusedReader(const std::vector<std::string>& paths);
+std::uint64_t ReadMissionExports(DllExportReader32& reader);
+PhaseResult MeasureWriteTable(const std::vector<std::string>& paths, std::size_t jobCount, std::size_t queueDepth = 0);
+std::size_t GetRepetitionCount(std::size_t corpusSize);
+void WriteResultHeader();
+void WriteResult(std::size_t corpusSize, const std::string& phase, const PhaseResult& result);
+
+// Number of readers open at once while measuring construction and lookup separately
+constexpr std::size_t readerBatchSize = 1000;
+
+// Small corpora are scanned repeatedly, so each measurement covers at least this many files
+constexpr std::size_t minimumFilesMeasured = 10000;
+
+// Header reads kept in flight when measuring the io_uring prefix reader
+constexpr std::size_t benchQueueDepth = 64;
+
+// Prevents lookups from being optimized away
+volatile std::uint64_t lookupSink;
+
+
+int main(int argc, char** argv)
+{
+	try {
+		const std::vector<std::string> arguments(argv + 1, argv + argc);
+		if (arguments.empty()) {
+			std::cout << "Usage: missionScannerBench corpusDirectory [maxCorpusSize] [paddingSectionCount] [fillerExportCount]" << std::endl;
+			return 0;
+		}
+
+		const fs::path corpusDirectory(arguments[0]);
+		const std::size_t maxCorpusSize = ParseCount(arguments, 1, 100000);
+
+		SyntheticMissionDllOptions dllOptions;
+		dllOptions.paddingSectionCount = ParseCount(arguments, 2, dllOptions.paddingSectionCount);
+		dllOptions.fillerExportCount = ParseCount(arguments, 3, dllOptions.fillerExportCount);
+
+		std::cout << "Generating " << maxCorpusSize << " DLLs in " << corpusDirectory.string() << std::endl;
+		const auto corpusPaths = GenerateCorpus(corpusDirectory, maxCorpusSize, dllOptions);
+
+		const std::size_t hardwareJobCount = std::max(1u, std::thread::hardware_concurrency());
+
+		WriteResultHeader();
+		for (std::size_t corpusSize = 10; corpusSize <= maxCorpusSize; corpusSize *= 10) {
+			const std::vector<std::string> paths(corpusPaths.begin(), corpusPaths.begin() + corpusSize);
+
+			PhaseResult construction;
+			PhaseResult lookup;
+			MeasureReader(paths, construction, lookup);
+			WriteResult(corpusSize, "construct", construction);
+			WriteResult(corpusSize, "lookup", lookup);
+			WriteResult(corpusSize, "reused open+lookup", MeasureReusedReader(paths));
+
+			WriteResult(corpusSize, "WriteTable -J 1", MeasureWriteTable(paths, 1));
+			WriteResult(corpusSize, "WriteTable -J 1 --QueueDepth " + std::to_string(benchQueueDepth), MeasureWriteTable(paths, 1, benchQueueDepth));
+			if (hardwareJobCount > 1) {
+				WriteResult(corpusSize, "WriteTable -J " + std::to_string(hardwareJobCount), MeasureWriteTable(paths, hardwareJobCount));
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+
+void PhaseResult::Add(const PhaseResult& other)
+{
+	fileCount += other.fileCount;
+	duration += other.duration;
+	counters.bytesRead += other.counters.bytesRead;
+	counters.ioSyscalls += other.counters.ioSyscalls;
+	counters.pageFaults += other.counters.pageFaults;
+}
+
+std::size_t ParseCount(const std::vector<std::string>& arguments, std::size_t index, std::size_t defaultValue)
+{
+	if (index >= arguments.size()) {
+		return defaultValue;
+	}
+
+	std::size_t charsProcessed = 0;
+	const auto count = std::stoul(arguments[index], &charsProcessed);
+	if (charsProcessed != arguments[index].size()) {
+		throw std::runtime_error("Invalid count : " + arguments[index]);
+	}
+
+	return count;
+}
+
+// Mission details vary between files, so string lengths and values are not identical
+std::vector<std::string> GenerateCorpus(const fs::path& directory, std::size_t count, const SyntheticMissionDllOptions& baseOptions)
+{
+	fs::create_directories(directory);
+
+	std::vector<std::string> paths;
+	paths.reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		auto options = baseOptions;
+		// Negative mission types from MultiLastOneStanding to Colony, then campaign mission numbers from 1
+		options.missionType = static_cast<int>(i % 20) - 8;
+		if (options.missionType >= 0) {
+			++options.missionType;
+		}
+		options.numPlayers = static_cast<int>(i % 6) + 1;
+		options.checksum = static_cast<int>(i);
+		options.mapName = "map" + std::to_string(i % 97) + ".map";
+		options.levelDesc = std::string("Synthetic mission ") + std::string(i % 40, '.') + std::to_string(i);
+
+		const auto filename = "m" + std::to_string(1000000 + i).substr(1) + ".dll";
+		paths.push_back((directory / filename).string());
+		WriteSyntheticMissionDll(paths.back(), options);
+	}
+
+	return paths;
+}
+
+// Readers are opened in batches, so construction and lookup are timed separately without exhausting mappings
+void MeasureReader(const std::vector<std::string>& paths, PhaseResult& construction, PhaseResult& lookup)
+{
+	const auto repetitionCount = GetRepetitionCount(paths.size());
+
+	std::vector<DllExportReader32> readers;
+	readers.reserve(readerBatchSize);
+
+	for (std::size_t repetition = 0; repetition < repetitionCount; ++repetition) {
+		for (std::size_t batchStart = 0; batchStart < paths.size(); batchStart += readerBatchSize) {
+			const auto batchEnd = std::min(paths.size(), batchStart + readerBatchSize);
+			const auto batchSize = batchEnd - batchStart;
+
+			auto startCounters = ReadProcessCounters();
+			auto startTime = Clock::now();
+			for (std::size_t i = batchStart; i < batchEnd; ++i) {
+				readers.emplace_back(paths[i]);
+			}
+			auto endTime = Clock::now();
+			construction.Add({ batchSize, endTime - startTime, ReadProcessCounters() - startCounters });
+
+			startCounters = ReadProcessCounters();
+			startTime = Clock::now();
+			std::uint64_t sum = 0;
+			for (auto& reader : readers) {
+				sum += ReadMissionExports(reader);
+			}
+			endTime = Clock::now();
+			lookupSink = sum;
+			lookup.Add({ batchSize, endTime - startTime, ReadProcessCounters() - startCounters });
+
+			// Unmapping is part of the cost of opening a reader
+			startCounters = ReadProcessCounters();
+			startTime = Clock::now();
+			readers.clear();
+			endTime = Clock::now();
+			construction.Add({ 0, endTime - startTime, ReadProcessCounters() - startCounters });
+		}
+	}
+}
+
+// A single reader opens each file in turn, as WriteTable's workers do
+PhaseResult MeasureReusedReader(const std::vector<std::string>& paths)
+{
+	const auto repetitionCount = GetRepetitionCount(paths.size());
+	DllExportReader32 reader;
+	std::uint64_t sum = 0;
+
+	PhaseResult result;
+	const auto startCounters = ReadProcessCounters();
+	const auto startTime = Clock::now();
+	for (std::size_t repetition = 0; repetition < repetitionCount; ++repetition) {
+		for (const auto& path : paths) {
+			reader.Open(path);
+			sum += ReadMissionExports(reader);
+		}
+	}
+	reader.Close();
+	result.duration = Clock::now() - startTime;
+	result.counters = ReadProcessCounters() - startCounters;
+	result.fileCount = paths.size() * repetitionCount;
+
+	lookupSink = sum;
+	return result;
+}
+
+std::uint64_t ReadMissionExports(DllExportReader32& reader)
+{
+	const auto [descBlock, mapName, techtreeName, levelDesc] = reader.ReadExports<AIModDesc32, std::string_view, std::string_view, std::string_view>(
+		{ "DescBlock", "MapName", "TechtreeName", "LevelDesc" });
+
+	return descBlock.checksum + mapName.size() + techtreeName.size() + levelDesc.size();
+}
+
+PhaseResult MeasureWriteTable(const std::vector<std::string>& paths, std::size_t jobCount, std::size_t queueDepth)
+{
+	ScanOptions scanOptions;
+	scanOptions.writeLegend = false;
+	scanOptions.jobCount = jobCount;
+	scanOptions.queueDepth = queueDepth;
+
+	NullStreamBuffer nullStreamBuffer;
+	auto* const coutStreamBuffer = std::cout.rdbuf(&nullStreamBuffer);
+
+	PhaseResult result;
+	const auto repetitionCount = GetRepetitionCount(paths.size());
+	const auto startCounters = ReadProcessCounters();
+	const auto startTime = Clock::now();
+	try {
+		for (std::size_t repetition = 0; repetition < repetitionCount; ++repetition) {
+			WriteTable(paths, scanOptions);
+		}
+	}
+	catch (...) {
+		std::cout.rdbuf(coutStreamBuffer);
+		throw;
+	}
+	result.duration = Clock::now() - startTime;
+	result.counters = ReadProcessCounters() - startCounters;
+	result.fileCount = paths.size() * repetitionCount;
+
+	std::cout.rdbuf(coutStreamBuffer);
+	return result;
+}
+
+std::size_t GetRepetitionCount(std::size_t corpusSize)
+{
+	return std::max<std::size_t>(1, minimumFilesMeasured / corpusSize);
+}
+
+void WriteResultHeader()
+{
+	std::cout << std::endl;
+	std::cout << std::left << std::setw(10) << "DLLs" << std::setw(32) << "Phase";
+	std::cout << std::right << std::setw(14) << "Files/sec" << std::setw(14) << "Bytes/file";
+	std::cout << std::setw(18) << "IO syscalls/file" << std::setw(16) << "Faults/file" << std::endl;
+}
+
+void WriteResult(std::size_t corpusSize, const std::string& phase, const PhaseResult& result)
+{
+	const double seconds = std::chrono::duration<double>(result.duration).count();
+	const double fileCount = static_cast<double>(std::max<std::size_t>(1, result.fileCount));
+
+	std::cout << std::left << std::setw(10) << corpusSize << std::setw(32) << phase << std::right;
+	std::cout << std::fixed << std::setprecision(0) << std::setw(14) << (seconds > 0 ? fileCount / seconds : 0.0);
+	std::cout << std::setprecision(1) << std::setw(14) << result.counters.bytesRead / fileCount;
+	std::cout << std::setprecision(2) << std::setw(18) << result.counters.ioSyscalls / fileCount;
+	std::cout << std::setw(16) << result.counters.pageFaults / fileCount << std::endl;
+}
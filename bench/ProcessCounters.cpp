@@ -0,0 +1,70 @@
+#include "ProcessCounters.h"
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+
+ProcessCounters MeasureSampleCost();
+std::uint64_t SubtractClamped(std::uint64_t end, std::uint64_t start, std::uint64_t sampleCost);
+
+
+ProcessCounters ReadProcessCounters()
+{
+	ProcessCounters counters;
+
+#ifdef __linux__
+	std::ifstream file("/proc/self/io");
+	std::string key;
+	std::uint64_t value;
+	while (file >> key >> value) {
+		if (key == "rchar:") {
+			counters.bytesRead = value;
+		}
+		else if (key == "syscr:" || key == "syscw:") {
+			counters.ioSyscalls += value;
+		}
+	}
+
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		counters.pageFaults = static_cast<std::uint64_t>(usage.ru_minflt) + static_cast<std::uint64_t>(usage.ru_majflt);
+	}
+#endif
+
+	return counters;
+}
+
+ProcessCounters operator-(const ProcessCounters& end, const ProcessCounters& start)
+{
+	static const ProcessCounters sampleCost = MeasureSampleCost();
+
+	ProcessCounters difference;
+	difference.bytesRead = SubtractClamped(end.bytesRead, start.bytesRead, sampleCost.bytesRead);
+	difference.ioSyscalls = SubtractClamped(end.ioSyscalls, start.ioSyscalls, sampleCost.ioSyscalls);
+	difference.pageFaults = SubtractClamped(end.pageFaults, start.pageFaults, sampleCost.pageFaults);
+	return difference;
+}
+
+
+// Reading /proc/self/io is itself counted, so measure back to back samples
+ProcessCounters MeasureSampleCost()
+{
+	ReadProcessCounters(); // Warm up, so first use allocations are not counted
+	const auto start = ReadProcessCounters();
+	const auto end = ReadProcessCounters();
+
+	ProcessCounters sampleCost;
+	sampleCost.bytesRead = end.bytesRead - start.bytesRead;
+	sampleCost.ioSyscalls = end.ioSyscalls - start.ioSyscalls;
+	sampleCost.pageFaults = 0; // Faults are from first use only, and not repeated
+	return sampleCost;
+}
+
+std::uint64_t SubtractClamped(std::uint64_t end, std::uint64_t start, std::uint64_t sampleCost)
+{
+	const auto difference = end - start;
+	return difference > sampleCost ? difference - sampleCost : 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Process wide I/O and paging counters, for attributing costs to a benchmark phase.
+// Read from /proc/self/io and getrusage on Linux. Always zero on other platforms.
+struct ProcessCounters
+{
+	// Bytes passed to read family system calls, including page cache hits. Excludes memory mapped reads.
+	std::uint64_t bytesRead = 0;
+
+	// Read and write family system calls. Open, close, stat and mapping calls are not counted by the kernel.
+	std::uint64_t ioSyscalls = 0;
+
+	// Minor and major page faults. Memory mapped files are read through page faults.
+	std::uint64_t pageFaults = 0;
+};
+
+ProcessCounters ReadProcessCounters();
+
+// Difference between samples, less the cost of taking a sample
+ProcessCounters operator-(const ProcessCounters& end, const ProcessCounters& start);
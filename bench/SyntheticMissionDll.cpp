@@ -0,0 +1,203 @@
+#include "SyntheticMissionDll.h"
+#include "../PEDataStructures.h"
+#include "../Outpost2DllExportedDefinitions.h"
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+
+template <typename DataType>
+void WriteAt(std::vector<char>& buffer, std::size_t offset, const DataType& value);
+std::size_t AppendString(std::vector<char>& buffer, const std::string& text);
+std::size_t AlignUp(std::size_t value, std::size_t alignment);
+std::string MakeSectionName(std::size_t index);
+
+constexpr std::uint32_t imageBase = 0x10000000;
+constexpr std::size_t fileAlignment = 0x200;
+constexpr std::size_t sectionAlignment = 0x1000;
+constexpr std::size_t peSignatureOffset = 0x80;
+constexpr std::size_t dataDirectoryCount = 16;
+
+
+std::vector<char> BuildSyntheticMissionDll(const SyntheticMissionDllOptions& options)
+{
+	const std::size_t sectionCount = options.paddingSectionCount + 1;
+	const std::size_t coffHeaderOffset = peSignatureOffset + sizeof(std::array<char, 4>);
+	const std::size_t imageHeaderOffset = coffHeaderOffset + sizeof(CoffHeader);
+	const std::size_t dataDirectoriesOffset = imageHeaderOffset + sizeof(Image32Bit);
+	const std::size_t sectionTablesOffset = dataDirectoriesOffset + dataDirectoryCount * sizeof(ImageDataDirectory);
+	const std::size_t sizeOfHeaders = AlignUp(sectionTablesOffset + sectionCount * sizeof(SectionTable), fileAlignment);
+
+	// Export section is placed last, so finding it requires passing every padding section
+	const std::size_t exportSectionIndex = options.paddingSectionCount;
+	const std::uint32_t exportSectionRva = static_cast<std::uint32_t>((exportSectionIndex + 1) * sectionAlignment);
+	const std::size_t exportSectionOffset = sizeOfHeaders + options.paddingSectionCount * fileAlignment;
+
+	// Name pointer table must be lexically sorted, with the address table in matching order
+	std::vector<std::string> exportNames{ "DescBlock", "LevelDesc", "MapName", "TechtreeName" };
+	for (std::size_t i = 0; i < options.fillerExportCount; ++i) {
+		std::array<char, 32> name;
+		std::snprintf(name.data(), name.size(), "Export%05zu", i);
+		exportNames.push_back(name.data());
+	}
+	std::sort(exportNames.begin(), exportNames.end());
+	const std::size_t exportCount = exportNames.size();
+
+	// Lay out the export section contents, tracking offsets relative to the section start
+	std::vector<char> section(sizeof(ExportDirectoryTable));
+	const std::size_t exportAddressTableOffset = section.size();
+	section.resize(section.size() + exportCount * sizeof(std::uint32_t));
+	const std::size_t namePointerTableOffset = section.size();
+	section.resize(section.size() + exportCount * sizeof(std::uint32_t));
+	const std::size_t ordinalTableOffset = section.size();
+	section.resize(section.size() + exportCount * sizeof(std::uint16_t));
+
+	const std::size_t dllNameOffset = AppendString(section, "synthetic.dll");
+	std::vector<std::size_t> nameOffsets;
+	for (const auto& exportName : exportNames) {
+		nameOffsets.push_back(AppendString(section, exportName));
+	}
+
+	section.resize(AlignUp(section.size(), sizeof(std::uint32_t)));
+	const std::size_t descBlockOffset = section.size();
+	section.resize(section.size() + sizeof(AIModDesc32));
+	const std::size_t mapNameOffset = AppendString(section, options.mapName);
+	const std::size_t levelDescOffset = AppendString(section, options.levelDesc);
+	const std::size_t techtreeNameOffset = AppendString(section, options.techtreeName);
+	const std::size_t fillerDataOffset = AppendString(section, "");
+
+	const auto toRva = [exportSectionRva](std::size_t offset) {
+		return static_cast<std::uint32_t>(exportSectionRva + offset);
+	};
+
+	AIModDesc32 descBlock;
+	descBlock.missionType = options.missionType;
+	descBlock.numPlayers = options.numPlayers;
+	descBlock.maxTechLevel = options.maxTechLevel;
+	descBlock.boolUnitMission = options.boolUnitMission;
+	descBlock.mapName = imageBase + toRva(mapNameOffset);
+	descBlock.levelDesc = imageBase + toRva(levelDescOffset);
+	descBlock.techtreeName = imageBase + toRva(techtreeNameOffset);
+	descBlock.checksum = options.checksum;
+	WriteAt(section, descBlockOffset, descBlock);
+
+	for (std::size_t i = 0; i < exportCount; ++i) {
+		std::size_t targetOffset = fillerDataOffset;
+		if (exportNames[i] == "DescBlock") {
+			targetOffset = descBlockOffset;
+		}
+		else if (exportNames[i] == "LevelDesc") {
+			targetOffset = levelDescOffset;
+		}
+		else if (exportNames[i] == "MapName") {
+			targetOffset = mapNameOffset;
+		}
+		else if (exportNames[i] == "TechtreeName") {
+			targetOffset = techtreeNameOffset;
+		}
+
+		WriteAt(section, exportAddressTableOffset + i * sizeof(std::uint32_t), toRva(targetOffset));
+		WriteAt(section, namePointerTableOffset + i * sizeof(std::uint32_t), toRva(nameOffsets[i]));
+		WriteAt(section, ordinalTableOffset + i * sizeof(std::uint16_t), static_cast<std::uint16_t>(i));
+	}
+
+	ExportDirectoryTable exportDirectoryTable{};
+	exportDirectoryTable.nameRva = toRva(dllNameOffset);
+	exportDirectoryTable.ordinalBase = 1;
+	exportDirectoryTable.addressTableEntries = static_cast<std::uint32_t>(exportCount);
+	exportDirectoryTable.numberOfNamePointers = static_cast<std::uint32_t>(exportCount);
+	exportDirectoryTable.exportAddressTableRva = toRva(exportAddressTableOffset);
+	exportDirectoryTable.namePointerRva = toRva(namePointerTableOffset);
+	exportDirectoryTable.ordinalTableRva = toRva(ordinalTableOffset);
+	WriteAt(section, 0, exportDirectoryTable);
+
+	const std::size_t exportSectionVirtualSize = section.size();
+	section.resize(AlignUp(section.size(), fileAlignment));
+
+	// Headers, padding sections, then the export section
+	std::vector<char> image(exportSectionOffset);
+	image[0] = 'M';
+	image[1] = 'Z';
+	WriteAt(image, 0x3c, static_cast<std::uint32_t>(peSignatureOffset));
+	WriteAt(image, peSignatureOffset, std::array<char, 4>{ 'P', 'E', '\0', '\0' });
+
+	CoffHeader coffHeader{};
+	coffHeader.machine = 0x14c; // IMAGE_FILE_MACHINE_I386
+	coffHeader.numberOfSections = static_cast<std::uint16_t>(sectionCount);
+	coffHeader.sizeOfOptionalHeader = static_cast<std::uint16_t>(sizeof(Image32Bit) + dataDirectoryCount * sizeof(ImageDataDirectory));
+	coffHeader.characteristics = 0x2102; // IMAGE_FILE_DLL | IMAGE_FILE_32BIT_MACHINE | IMAGE_FILE_EXECUTABLE_IMAGE
+	WriteAt(image, coffHeaderOffset, coffHeader);
+
+	Image32Bit image32Bit{};
+	image32Bit.magic = 0x10b;
+	image32Bit.imageBase = imageBase;
+	image32Bit.sectionAlignment = static_cast<std::uint32_t>(sectionAlignment);
+	image32Bit.fileAlignment = static_cast<std::uint32_t>(fileAlignment);
+	image32Bit.sizeOfImage = static_cast<std::uint32_t>(AlignUp(exportSectionRva + exportSectionVirtualSize, sectionAlignment));
+	image32Bit.sizeOfHeaders = static_cast<std::uint32_t>(sizeOfHeaders);
+	image32Bit.numberOfRvaAndSizes = static_cast<std::uint32_t>(dataDirectoryCount);
+	WriteAt(image, imageHeaderOffset, image32Bit);
+
+	WriteAt(image, dataDirectoriesOffset, ImageDataDirectory{ exportSectionRva, static_cast<std::uint32_t>(descBlockOffset) });
+
+	for (std::size_t i = 0; i < sectionCount; ++i) {
+		SectionTable sectionTable{};
+		const auto name = (i == exportSectionIndex) ? std::string(".rdata") : MakeSectionName(i);
+		std::memcpy(sectionTable.name, name.data(), std::min(name.size(), sizeof(sectionTable.name)));
+		sectionTable.virtualAddress = static_cast<std::uint32_t>((i + 1) * sectionAlignment);
+		sectionTable.pointerToRawData = static_cast<std::uint32_t>(sizeOfHeaders + i * fileAlignment);
+		sectionTable.virtualSize = static_cast<std::uint32_t>(i == exportSectionIndex ? exportSectionVirtualSize : fileAlignment);
+		sectionTable.sizeOfRawData = static_cast<std::uint32_t>(i == exportSectionIndex ? section.size() : fileAlignment);
+		sectionTable.characteristics = 0x40000040; // IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ
+		WriteAt(image, sectionTablesOffset + i * sizeof(SectionTable), sectionTable);
+	}
+
+	image.insert(image.end(), section.begin(), section.end());
+	return image;
+}
+
+void WriteSyntheticMissionDll(const std::string& filename, const SyntheticMissionDllOptions& options)
+{
+	const auto image = BuildSyntheticMissionDll(options);
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	file.write(image.data(), image.size());
+	if (!file) {
+		throw std::runtime_error("Unable to write synthetic DLL : " + filename);
+	}
+}
+
+
+template <typename DataType>
+void WriteAt(std::vector<char>& buffer, std::size_t offset, const DataType& value)
+{
+	std::memcpy(buffer.data() + offset, &value, sizeof(DataType));
+}
+
+// Returns offset of the appended null terminated string
+std::size_t AppendString(std::vector<char>& buffer, const std::string& text)
+{
+	const auto offset = buffer.size();
+	buffer.insert(buffer.end(), text.begin(), text.end());
+	buffer.push_back('\0');
+	return offset;
+}
+
+std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string MakeSectionName(std::size_t index)
+{
+	constexpr std::array<const char*, 4> commonNames{ ".text", ".data", ".bss", ".idata" };
+	if (index < commonNames.size()) {
+		return commonNames[index];
+	}
+
+	return ".pad" + std::to_string(index);
+}
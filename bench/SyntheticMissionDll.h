@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+// Describes a generated 32 bit mission DLL.
+// Generated DLLs contain headers, section tables and an export table, but no code.
+struct SyntheticMissionDllOptions
+{
+	// Sections before the export section. Each is a single file aligned block of zeros.
+	std::size_t paddingSectionCount = 2;
+
+	// Exported names in addition to the mission exports, named Export00000, Export00001...
+	std::size_t fillerExportCount = 8;
+
+	int missionType = -8;
+	int numPlayers = 6;
+	int maxTechLevel = 12;
+	int boolUnitMission = 0;
+	int checksum = 0x1234;
+	std::string mapName = "synthetic.map";
+	std::string levelDesc = "Synthetic mission";
+	std::string techtreeName = "MULTITEK.TXT";
+};
+
+// DescBlock, LevelDesc, MapName and TechtreeName are exported, matching a real mission DLL.
+// DescBlock pointers hold virtual addresses of the strings, as the linker would emit them.
+std::vector<char> BuildSyntheticMissionDll(const SyntheticMissionDllOptions& options);
+
+void WriteSyntheticMissionDll(const std::string& filename, const SyntheticMissionDllOptions& options);
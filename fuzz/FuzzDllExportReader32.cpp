@@ -0,0 +1,46 @@
+#include "../DllExportReader32.h"
+#include "../Outpost2DllExportedDefinitions.h"
+#include <algorithm>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+
+// libFuzzer entry point. Runs the steps MissionScanner takes for each DLL against arbitrary bytes.
+// Rejected files must throw std::exception. Crashes, sanitizer reports, hangs and large allocations are failures.
+// Seed the corpus with real mission DLLs, so mutations start from valid headers and export tables.
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+	const std::string_view fileImage(reinterpret_cast<const char*>(data), size);
+	DllExportReader32 reader;
+
+	try {
+		const auto prefixSize = std::min(size, DllExportReader32::headerProbeSize);
+		reader.ProbeHeaders(fileImage.substr(0, prefixSize), prefixSize == size);
+	}
+	catch (const std::exception&) {
+	}
+
+	try {
+		reader.Open(fileImage);
+
+		std::size_t exportCount = 0;
+		reader.ForEachExport([&exportCount](const DllExportReader32::ExportEntry&) { ++exportCount; });
+
+		if (!reader.DoesExportExist("LevelDesc")) {
+			return 0;
+		}
+
+		const auto descBlock = reader.ReadExport<AIModDesc32>("DescBlock");
+		reader.ReadStringAtVirtualAddress(descBlock.mapName);
+		reader.ReadStringAtVirtualAddress(descBlock.techtreeName);
+		reader.ReadStringAtVirtualAddress(descBlock.levelDesc);
+
+		reader.ReadExports<std::string_view, std::string_view, std::string_view>({ "MapName", "TechtreeName", "LevelDesc" });
+	}
+	catch (const std::exception&) {
+	}
+
+	return 0;
+}